@@ -0,0 +1,71 @@
+#include "attacks.hpp"
+#include <tintoretto.hpp>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+/**
+ * Compares the magic and PEXT slider backends on this machine, and checks that the startup dispatch picked the faster one.
+ */
+
+const int N = 1 << 16; // lookups per round, small enough to stay in L1/L2 alongside the tables
+const int ROUNDS = 100;
+const int REPEATS = 7; // keep the best of several runs, timings on a busy machine are noisy
+
+std::vector<Square> squares(N);
+std::vector<Bitboard> occupancies(N);
+
+/**
+ * Returns the time per lookup (rook + bishop) in nanoseconds, with the backend known at compile time as in move generation
+ */
+template<SliderBackend Backend>
+double bench() {
+    initSliders(Backend);
+    Bitboard sink = 0;
+
+    Task task("Benchmarking");
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < N; ++i) {
+            // feed the result back into the occupancy so that lookups cannot overlap for free
+            sink += rookAttacks<Backend>(squares[i], occupancies[i] ^ (sink & 1)) + bishopAttacks<Backend>(squares[i], occupancies[i]);
+        }
+    }
+    task.complete();
+
+    if (sink == 42) Message::print("Lucky checksum!"); // keeps the loop from being optimized away
+    return static_cast<double>(task.getTimeNs()) / (static_cast<double>(N) * ROUNDS);
+}
+
+int main() {
+    std::mt19937_64 rng(42);
+    for (int i = 0; i < N; ++i) {
+        squares[i] = rng() % 64;
+        occupancies[i] = rng() & rng();
+    }
+
+    const SliderBackend detected = detectSliderBackend();
+    Message(std::string("Startup dispatch picked: ") + (detected == SliderBackend::PEXT ? "PEXT" : "magic"));
+
+    if (detected != SliderBackend::PEXT) {
+        Message("No BMI2 on this CPU, only the magic backend is available", "?");
+        return 0;
+    }
+
+    double magicNs = 1e9, pextNs = 1e9;
+    ProgressBar bar(REPEATS);
+    Message::mute();
+    for (int repeat = 0; repeat < REPEATS; ++repeat) {
+        magicNs = std::min(magicNs, bench<SliderBackend::MAGIC>());
+        pextNs = std::min(pextNs, bench<SliderBackend::PEXT>());
+        Message::unmute();
+        bar.update();
+        Message::mute();
+    }
+    Message::unmute();
+    Message::print("magic: " + std::to_string(magicNs) + " ns per rook + bishop lookup");
+    Message::print("PEXT:  " + std::to_string(pextNs) + " ns per rook + bishop lookup");
+
+    Test test("Checking that the dispatch picked the faster backend");
+    test.complete(pextNs <= magicNs);
+    initSliders(detected);
+}
@@ -1,5 +1,179 @@
-#include "tintoretto.hpp"
+#include "perft.hpp"
+#include "movePicker.hpp"
+#include "ttableBase.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <new>
+
+/**
+ * Minimal UCI front end: options (with saving / loading the hash to resume an analysis), positions and
+ * perft. There is no search yet, so 'go' answers with the first move of the move picker (the TT move if
+ * there is one).
+ */
+
+static constexpr size_t DEFAULT_HASH_MB = 16;
+static constexpr size_t MAX_HASH_MB = 1 << 17; // 128 GB
+static constexpr unsigned MAX_THREADS = 256;
+static constexpr const char* DEFAULT_HASH_FILE = "hash.bin";
+
+/**
+ * position [startpos | fen <fields>] [moves <moves>]
+ */
+static void setPosition(Position& position, std::istringstream& command) {
+    std::string token, fen;
+    command >> token;
+    if (token == "startpos") {
+        fen = Position::startpos;
+        command >> token; // "moves", if any
+    } else if (token == "fen") {
+        while (command >> token && token != "moves") fen += token + " ";
+    } else {
+        return;
+    }
+    const FENError error = position.parseFEN(fen);
+    if (error != FENError::NONE) {
+        std::cout << "info string invalid fen: " << getFENErrorMessage(error) << std::endl;
+        position.fromFEN(Position::startpos);
+        return;
+    }
+    while (command >> token) {
+        const Move move = parseUCIMove(position, token);
+        if (move.isNull()) {
+            std::cout << "info string illegal move " << token << std::endl;
+            return;
+        }
+        position.play(move);
+    }
+}
+
+/**
+ * Value of a spin option, false if it is not a number or is out of [min, max] (no wrapping of "-5")
+ */
+static bool parseSpin(const std::string& value, long long min, long long max, long long& result) {
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+    return error == std::errc() && end == value.data() + value.size() && result >= min && result <= max;
+}
+
+/**
+ * setoption name <name> [value <value>], the value may have spaces (file names)
+ */
+static void setOption(TranspositionTable& table, Position& position, unsigned& threads, std::string& hashFile, std::istringstream& command) {
+    std::string token, name, value;
+    command >> token; // "name"
+    while (command >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    std::getline(command >> std::ws, value);
+    try {
+        long long spin;
+        if (name == "Hash") {
+            if (!parseSpin(value, 1, MAX_HASH_MB, spin)) {
+                std::cout << "info string Hash must be between 1 and " << MAX_HASH_MB << " MB" << std::endl;
+                return;
+            }
+            const size_t megabytes = static_cast<size_t>(spin);
+            try {
+                table.resize(megabytes, threads);
+                std::cout << "info string hash " << megabytes << " MB" << (table.usesHugePages() ? ", huge pages" : "") << std::endl;
+            } catch (const std::bad_alloc&) {
+                std::cout << "info string not enough memory for a " << megabytes << " MB hash, using "
+                          << TranspositionTable::FALLBACK_MEGABYTES << " MB" << std::endl;
+            }
+            position.setPrefetchTarget(table.getPrefetchTarget()); // the buckets moved
+        } else if (name == "Threads") {
+            if (!parseSpin(value, 1, MAX_THREADS, spin)) {
+                std::cout << "info string Threads must be between 1 and " << MAX_THREADS << std::endl;
+                return;
+            }
+            threads = static_cast<unsigned>(spin);
+        } else if (name == "Hash File") {
+            hashFile = value;
+        } else if (name == "Save Hash") {
+            table.save(hashFile);
+            std::cout << "info string hash saved to " << hashFile << std::endl;
+        } else if (name == "Load Hash") {
+            table.load(hashFile);
+            std::cout << "info string hash loaded from " << hashFile << std::endl;
+        } else {
+            std::cout << "info string unknown option " << name << std::endl;
+        }
+    } catch (const std::runtime_error& error) { // snapshot files
+        std::cout << "info string " << error.what() << std::endl;
+    }
+}
+
+/**
+ * go perft <depth>, or any other go: the first move of the picker
+ */
+static void go(Position& position, TranspositionTable& table, unsigned threads, std::istringstream& command) {
+    std::string token;
+    command >> token;
+    if (token == "perft") {
+        int depth = 1;
+        command >> depth;
+        const auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = 0;
+        for (const DivideEntry& entry : parallelDivide(position, std::max(depth, 1), threads)) {
+            char move[Move::UCI_LENGTH];
+            entry.move.toUCI(move);
+            std::cout << move << ": " << entry.nodes << "\n";
+            nodes += entry.nodes;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "\nNodes searched: " << nodes << " (" << static_cast<uint64_t>(nodes / std::max(seconds, 1e-9) / 1000) << " knps)" << std::endl;
+        return;
+    }
+
+    table.newSearch();
+    TTData data;
+    const Move ttMove = table.probe(position.getZobristKey(), data) ? data.move.unpack(position) : Move();
+    MovePicker picker(position, ttMove);
+    const Move best = picker.next();
+    char move[Move::UCI_LENGTH] = "0000";
+    if (!best.isNull()) best.toUCI(move);
+    std::cout << "bestmove " << move << std::endl;
+}
 
 int main() {
-    Message("Not implemented yet!", "!");
-}
\ No newline at end of file
+    unsigned threads = 1;
+    std::string hashFile = DEFAULT_HASH_FILE; // for Save Hash / Load Hash, the table must have the size of the snapshot
+    TranspositionTable table(DEFAULT_HASH_MB, threads);
+    Position position;
+    position.setPrefetchTarget(table.getPrefetchTarget()); // kept through the position commands
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream command(line);
+        std::string token;
+        command >> token;
+        if (token == "uci") {
+            std::cout << "id name chess\n";
+            std::cout << "id author ProfesseurShadoko\n";
+            std::cout << "option name Hash type spin default " << DEFAULT_HASH_MB << " min 1 max " << MAX_HASH_MB << "\n";
+            std::cout << "option name Threads type spin default 1 min 1 max " << MAX_THREADS << "\n";
+            std::cout << "option name Hash File type string default " << DEFAULT_HASH_FILE << "\n";
+            std::cout << "option name Save Hash type button\n";
+            std::cout << "option name Load Hash type button\n";
+            std::cout << "uciok" << std::endl;
+        } else if (token == "isready") {
+            std::cout << "readyok" << std::endl;
+        } else if (token == "setoption") {
+            setOption(table, position, threads, hashFile, command);
+        } else if (token == "ucinewgame") {
+            table.clear(threads);
+            position.fromFEN(Position::startpos);
+        } else if (token == "position") {
+            setPosition(position, command);
+        } else if (token == "go") {
+            go(position, table, threads, command);
+        } else if (token == "d") {
+            std::cout << position.toFEN() << std::endl;
+        } else if (token == "quit") {
+            break;
+        } else if (!token.empty()) {
+            std::cout << "info string unknown command " << token << std::endl;
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#include "perft.hpp"
+#include <tintoretto.hpp>
+#include <cstring>
+#include <thread>
+
+/**
+ * Perft harness: move generation correctness and speed.
+ *
+ *   perft.exe                        standard suite, each position to depth 5 (or its deepest known count)
+ *   perft.exe --depth 6              deeper
+ *   perft.exe --fen "<fen>" -d 4     a single position, nothing to compare with
+ *   perft.exe --divide               perft of each root move, to compare with another engine
+ *   perft.exe --no-bulk              play the leaves instead of counting them (measures play / unplay too)
+ *   perft.exe --threads 8            spread the subtrees over 8 threads (0 --> one per core)
+ *   perft.exe --hash 256             cache subtree counts in a 256 MB table (cleared for each position)
+ */
+
+void printUsage() {
+    Message::print("usage: perft.exe [--depth N] [--fen \"<fen>\"] [--divide] [--no-bulk] [--threads N] [--hash MB]");
+}
+
+std::string formatNps(uint64_t nodes, long long timeNs) {
+    const double nps = timeNs > 0 ? static_cast<double>(nodes) * 1e9 / static_cast<double>(timeNs) : 0;
+    return std::to_string(static_cast<uint64_t>(nps / 1000)) + " knps";
+}
+
+/**
+ * Runs perft on the position, prints the divide if asked. Returns the node count and the time taken.
+ */
+uint64_t run(const std::string& name, const std::string& fen, int depth, bool bulk, bool showDivide, unsigned threads, PerftTable* table, long long& timeNs) {
+    const Position position(fen);
+    uint64_t nodes = 0;
+
+    Task task("Perft " + std::to_string(depth) + " " + name);
+    if (showDivide) {
+        std::vector<DivideEntry> entries = parallelDivide(position, depth, threads, bulk, table);
+        task.complete();
+        for (DivideEntry& entry : entries) {
+            Message::print(entry.move.toString() + ": " + std::to_string(entry.nodes));
+            nodes += entry.nodes;
+        }
+    } else {
+        nodes = parallelPerft(position, depth, threads, bulk, table);
+        task.complete();
+    }
+    timeNs = task.getTimeNs();
+    Message::print(std::to_string(nodes) + " nodes, " + formatNps(nodes, timeNs));
+    return nodes;
+}
+
+int main(int argc, char** argv) {
+    // !-- Arguments --! //
+    int depth = 5;
+    std::string fen;
+    bool bulk = true;
+    bool showDivide = false;
+    unsigned threads = 1;
+    size_t hashMegabytes = 0;
+    for (int i = 1; i < argc; ++i) {
+        if ((!strcmp(argv[i], "--depth") || !strcmp(argv[i], "-d")) && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--fen") && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (!strcmp(argv[i], "--divide")) {
+            showDivide = true;
+        } else if (!strcmp(argv[i], "--no-bulk")) {
+            bulk = false;
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            const int requested = std::atoi(argv[++i]);
+            threads = requested > 0 ? requested : std::max(1u, std::thread::hardware_concurrency());
+        } else if (!strcmp(argv[i], "--hash") && i + 1 < argc) {
+            hashMegabytes = std::max(0, std::atoi(argv[++i]));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (depth < 1) {
+        Message("Depth must be at least 1", "!");
+        return 1;
+    }
+    Message(std::string("Leaves are ") + (bulk ? "counted (bulk)" : "played") + ", " + std::to_string(threads) + " thread(s)");
+    std::unique_ptr<PerftTable> table;
+    if (hashMegabytes > 0) {
+        table = std::make_unique<PerftTable>(hashMegabytes);
+        Message("Perft table: " + std::to_string(table->getEntryCount()) + " entries");
+    }
+
+    // !-- Single position --! //
+    if (!fen.empty()) {
+        long long timeNs = 0;
+        try {
+            run("custom position", fen, depth, bulk, showDivide, threads, table.get(), timeNs);
+        } catch (const std::invalid_argument& e) {
+            Message(e.what(), "!");
+            return 1;
+        }
+        return 0;
+    }
+
+    // !-- Standard suite --! //
+    uint64_t totalNodes = 0;
+    long long totalNs = 0;
+    bool passed = true;
+    for (const PerftPosition& perftPosition : PERFT_SUITE) {
+        const int positionDepth = std::min<int>(depth, perftPosition.nodes.size());
+        long long timeNs = 0;
+        if (table) table->clear(); // each position is timed from scratch
+        const uint64_t nodes = run(perftPosition.name, perftPosition.fen, positionDepth, bulk, showDivide, threads, table.get(), timeNs);
+        if (nodes != perftPosition.nodes[positionDepth - 1]) {
+            Message("Expected " + std::to_string(perftPosition.nodes[positionDepth - 1]) + " nodes", "!");
+            passed = false;
+        }
+        totalNodes += nodes;
+        totalNs += timeNs;
+    }
+
+    Message::print("");
+    Message(std::to_string(totalNodes) + " nodes in " + std::to_string(totalNs / 1000000) + " ms, " + formatNps(totalNodes, totalNs), passed ? "#" : "!");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#include "attacks.hpp"
+#include "position.hpp"
+#include <tintoretto.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+int main() {
+    // every backend the CPU has: on a BMI2 CPU the magic numbers are the fallback, still to be checked
+    const SliderBackend detected = detectSliderBackend();
+    std::vector<SliderBackend> backends = {SliderBackend::MAGIC};
+    if (detected == SliderBackend::PEXT) backends.push_back(SliderBackend::PEXT);
+    bool passed = true;
+    for (SliderBackend backend : backends) {
+        initSliders(backend);
+        Test magic_test(std::string("Testing ") + (backend == SliderBackend::PEXT ? "PEXT" : "magic") + " lookups against ray walking");
+        std::mt19937_64 rng(42);
+        passed = true;
+        for (int i = 0; i < 100000; ++i) {
+            Square square = rng() % 64;
+            Bitboard occupied = rng() & rng(); // sparse boards, about 16 pieces
+            passed &= rookAttacks(square, occupied) == slidingAttacks(square, occupied, true);
+            passed &= bishopAttacks(square, occupied) == slidingAttacks(square, occupied, false);
+        }
+        magic_test.complete(passed);
+    }
+    initSliders(detected);
+
+    Test leaper_test("Testing leaper, between and line tables");
+    passed = popCount(knightAttacks(0)) == 2 && popCount(knightAttacks(27)) == 8;
+    passed &= popCount(kingAttacks(63)) == 3 && popCount(kingAttacks(36)) == 8;
+    passed &= pawnAttacks(Color::WHITE, 12) == (squareBB(19) | squareBB(21)); // e2 --> d3 f3
+    passed &= pawnAttacks(Color::BLACK, 8) == squareBB(1); // a2 --> b1
+    passed &= between(0, 63) == (slidingAttacks(0, squareBB(63), false) & ~squareBB(63)); // a1-h8 diagonal
+    passed &= between(4, 60) == (FILE_A << 4 & ~RANK_1 & ~RANK_8); // e1-e8
+    passed &= between(0, 10) == 0 && line(0, 10) == 0; // a1 and c2 are not aligned
+    passed &= line(9, 18) == line(0, 63) && aligned(0, 63, 27);
+    leaper_test.complete(passed);
+
+    Test attacked_test("Testing attacked squares in Kiwipete");
+    Position position("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    passed = position.isAttacked(12, Color::BLACK); // e2 by the bishop on a6
+    passed &= !position.isAttacked(5, Color::BLACK); // f1, the bishop on e2 blocks a6
+    passed &= position.isAttacked(14, Color::BLACK); // g2 by the pawn on h3
+    passed &= position.getAttackersTo(28, position.getOccupied()) == (squareBB(18) | squareBB(21) | squareBB(45)); // e4: Nc3, Qf3 and Nf6
+    attacked_test.complete(passed);
+}
@@ -0,0 +1,89 @@
+#include "epd.hpp"
+#include "perft.hpp"
+#include <tintoretto.hpp>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+/**
+ * Same records: pieces, moves and texts
+ */
+bool sameBatches(const EPDBatch& a, const EPDBatch& b) {
+    if (a.records.size() != b.records.size() || a.errors != b.errors) return false;
+    for (size_t i = 0; i < a.records.size(); ++i) {
+        const EPDRecord& x = a.records[i];
+        const EPDRecord& y = b.records[i];
+        if (x.position.occupied != y.position.occupied || std::memcmp(x.position.pieces, y.position.pieces, sizeof(x.position.pieces)) != 0) return false;
+        if (std::memcmp(x.bestMoves, y.bestMoves, sizeof(x.bestMoves)) != 0 || std::memcmp(x.avoidMoves, y.avoidMoves, sizeof(x.avoidMoves)) != 0) return false;
+        if (a.getId(x) != b.getId(y) || a.getComment(x) != b.getComment(y)) return false;
+    }
+    return true;
+}
+
+int main() {
+    Test pack_test("Packed positions give back the same positions");
+    bool passed = sizeof(PackedPosition) == 32;
+    Position unpacked;
+    for (const PerftPosition& perftCase : PERFT_SUITE) {
+        Position position(perftCase.fen);
+        unpacked.unpack(position.pack());
+        passed &= unpacked.toFEN() == position.toFEN() && unpacked.getZobristKey() == position.getZobristKey();
+    }
+    pack_test.complete(passed);
+
+
+    // !-- A file of a few thousand lines, in several windows and chunks --! //
+    const std::string kiwipete = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+    const std::string enPassant = "4k3/8/8/3pP3/8/8/8/4K3 w - d6";
+    const size_t lines = 20000;
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "testEPD.epd";
+    {
+        std::ofstream file(path);
+        file << "# generated by testEPD\n\n";
+        for (size_t i = 0; i < lines; ++i) {
+            switch (i % 4) {
+                case 0: file << kiwipete << " bm O-O; am Bxa6 e5f7; id \"t." << i << "\"; c0 \"castle; then attack\";\n"; break;
+                case 1: file << Position::startpos << "\n"; break;
+                case 2: file << enPassant << " bm exd6+; id \"t." << i << "\";\r\n"; break;
+                case 3: file << (i % 8 == 3 ? "not a fen at all" : "4k3/8/8/8/8/8/8/4K3 w - - bm Qh5;") << "\n"; break;
+            }
+        }
+    }
+
+    Test load_test("Loading an EPD file");
+    const EPDBatch loaded = loadEPD(path.string(), {1});
+    passed = loaded.records.size() == lines / 4 * 3 && loaded.errors == lines / 4;
+    const Position kiwipetePosition(kiwipete);
+    const EPDRecord& first = loaded.records[0];
+    unpacked.unpack(first.position);
+    passed &= unpacked.toFEN() == kiwipetePosition.toFEN();
+    passed &= first.bestMoves[0].unpack(kiwipetePosition) == parseUCIMove(kiwipetePosition, "e1g1") && first.bestMoves[1].isNull();
+    passed &= first.avoidMoves[0].unpack(kiwipetePosition) == parseUCIMove(kiwipetePosition, "e2a6");
+    passed &= first.avoidMoves[1].unpack(kiwipetePosition) == parseUCIMove(kiwipetePosition, "e5f7");
+    passed &= loaded.getId(first) == "t.0" && loaded.getComment(first) == "castle; then attack";
+    unpacked.unpack(loaded.records[1].position);
+    passed &= unpacked.toFEN() == Position::startpos && loaded.getId(loaded.records[1]).empty() && loaded.records[1].bestMoves[0].isNull();
+    const EPDRecord& last = loaded.records.back();
+    unpacked.unpack(last.position);
+    passed &= loaded.getId(last) == "t." + std::to_string(lines - 2) && last.bestMoves[0].unpack(unpacked).isEnPassant();
+    load_test.complete(passed);
+
+    Test parallel_test("Parallel and windowed loads give the same records, in order");
+    EPDOptions small;
+    small.threads = 3;
+    small.windowBytes = 1 << 16; // a few lines cross the windows
+    size_t batchCount = 0;
+    streamEPD(path.string(), [&batchCount](const EPDBatch&) {batchCount++;}, small);
+    parallel_test.complete(sameBatches(loaded, loadEPD(path.string(), {4})) && sameBatches(loaded, loadEPD(path.string(), small)) && batchCount > 10);
+
+    Test missing_test("Missing files throw");
+    passed = false;
+    try {
+        loadEPD((std::filesystem::temp_directory_path() / "no such file.epd").string());
+    } catch (const std::runtime_error&) {
+        passed = true;
+    }
+    missing_test.complete(passed);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,275 @@
+#include "perft.hpp"
+#include "movePicker.hpp"
+#include <tintoretto.hpp>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+/**
+ * Every heap allocation of the program goes through here, so that the tests can check that none happens
+ */
+static size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* ptr = std::malloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {std::free(ptr);}
+void operator delete(void* ptr, size_t) noexcept {std::free(ptr);}
+
+/**
+ * Sorted copy, to compare move lists regardless of the order
+ */
+template<typename List>
+std::vector<uint32_t> sorted(const List& moves) {
+    std::vector<uint32_t> result;
+    for (const Move& move : moves) result.push_back(move.hash());
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+const uint64_t MAX_TEST_NODES = 200000; // the deeper counts are for app/perft.cpp
+
+int main() {
+    const std::vector<PerftPosition>& cases = PERFT_SUITE;
+
+    for (const PerftPosition& perftCase : cases) {
+        Test test("Perft " + perftCase.name);
+        Position position(perftCase.fen);
+        bool passed = true;
+        for (size_t depth = 1; depth <= perftCase.nodes.size() && perftCase.nodes[depth - 1] <= MAX_TEST_NODES; ++depth) {
+            passed &= perft(position, depth) == perftCase.nodes[depth - 1];
+            passed &= perft(position, depth, false) == perftCase.nodes[depth - 1]; // leaves played as well
+        }
+        passed &= position.toFEN() == Position(perftCase.fen).toFEN(); // play / unplay left it untouched
+        test.complete(passed);
+    }
+
+    Test parallelTest("Parallel perft and divide agree with the serial ones");
+    bool parallelPassed = true;
+    for (const PerftPosition& perftCase : cases) {
+        Position position(perftCase.fen);
+        const int depth = std::min<int>(3, perftCase.nodes.size());
+        parallelPassed &= parallelPerft(position, depth, 4) == perftCase.nodes[depth - 1];
+        parallelPassed &= parallelPerft(position, depth, 3, false) == perftCase.nodes[depth - 1];
+
+        std::vector<DivideEntry> serial = divide(position, depth), parallel = parallelDivide(position, depth, 4);
+        parallelPassed &= serial.size() == parallel.size();
+        for (size_t i = 0; parallelPassed && i < serial.size(); ++i) {
+            parallelPassed &= serial[i].move == parallel[i].move && serial[i].nodes == parallel[i].nodes;
+        }
+    }
+    parallelTest.complete(parallelPassed);
+
+    Test hashTest("Hashed perft gives the same counts, shared between threads");
+    bool hashPassed = true;
+    PerftTable table(1); // small: plenty of replacements
+    for (const PerftPosition& perftCase : cases) {
+        Position position(perftCase.fen);
+        const int depth = std::min<int>(4, perftCase.nodes.size());
+        table.clear();
+        hashPassed &= perft(position, depth, true, &table) == perftCase.nodes[depth - 1];
+        hashPassed &= perft(position, depth, true, &table) == perftCase.nodes[depth - 1]; // now mostly from the table
+        table.clear();
+        hashPassed &= parallelPerft(position, depth, 4, false, &table) == perftCase.nodes[depth - 1];
+        hashPassed &= position.toFEN() == Position(perftCase.fen).toFEN();
+    }
+    hashTest.complete(hashPassed);
+
+    Test keysTest("Incremental keys match the position rebuilt from FEN, two plies deep");
+    bool keysPassed = true;
+    auto sameKeys = [](const Position& a, const Position& b) {
+        return a.getZobristKey() == b.getZobristKey() && a.getPawnKey() == b.getPawnKey() && a.getMaterialKey() == b.getMaterialKey()
+            && a.getNonPawnKey(Color::WHITE) == b.getNonPawnKey(Color::WHITE) && a.getNonPawnKey(Color::BLACK) == b.getNonPawnKey(Color::BLACK);
+    };
+    for (const PerftPosition& perftCase : cases) {
+        Position position(perftCase.fen);
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        for (const Move& move : moves) {
+            position.play(move);
+            MoveList replies;
+            generateLegalMoves(position, replies);
+            for (const Move& reply : replies) {
+                position.play(reply);
+                keysPassed &= sameKeys(position, Position(position.toFEN()));
+                position.unplay(reply);
+            }
+            keysPassed &= sameKeys(position, Position(position.toFEN()));
+            position.unplay(move);
+        }
+        keysPassed &= sameKeys(position, Position(perftCase.fen));
+    }
+    keysTest.complete(keysPassed);
+
+    Test packedTest("Packed moves give back the same moves, two plies deep");
+    bool packedPassed = sizeof(PackedMove) == 2 && PackedMove().unpack(Position()).isNull();
+    for (const PerftPosition& perftCase : cases) {
+        Position position(perftCase.fen);
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        for (const Move& move : moves) {
+            packedPassed &= PackedMove(move).unpack(position) == move;
+            position.play(move);
+            MoveList replies;
+            generateLegalMoves(position, replies);
+            for (const Move& reply : replies) {
+                packedPassed &= PackedMove(reply).unpack(position) == reply;
+            }
+            position.unplay(move);
+        }
+    }
+    packedTest.complete(packedPassed);
+
+    Test uciTest("UCI strings give back the same moves, two plies deep");
+    bool uciPassed = true;
+    for (const PerftPosition& perftCase : cases) {
+        Position position(perftCase.fen);
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        for (const Move& move : moves) {
+            char buffer[Move::UCI_LENGTH];
+            const size_t length = move.toUCI(buffer);
+            uciPassed &= length == std::strlen(buffer) && move.toString() == buffer;
+            uciPassed &= parseUCIMove(position, std::string_view(buffer, length)) == move;
+            position.play(move);
+            MoveList replies;
+            generateLegalMoves(position, replies);
+            for (const Move& reply : replies) {
+                uciPassed &= parseUCIMove(position, std::string_view(buffer, reply.toUCI(buffer))) == reply;
+            }
+            position.unplay(move);
+        }
+    }
+    const Position start;
+    for (const char* text : {"", "e2", "e2e5", "e7e5", "e2e4x", "i2i4", "e2e4q", "e1g1", "b1c3 "}) {
+        uciPassed &= parseUCIMove(start, text).isNull(); // not moves, or not legal here
+    }
+    const Position castles("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"), blackCastles("r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1");
+    for (const char* text : {"e1g2", "e1c2"}) uciPassed &= parseUCIMove(castles, text).isNull(); // two columns, off the row
+    for (const char* text : {"e8g7", "e8c7"}) uciPassed &= parseUCIMove(blackCastles, text).isNull();
+    uciPassed &= parseUCIMove(Position("4k3/8/8/8/8/4p3/4P3/4K3 w - - 0 1"), "e2e3").isNull(); // blocked pawn
+    uciPassed &= parseUCIMove(Position("8/4P3/8/8/8/8/8/k6K w - - 0 1"), "e7e8N") == Move(52, 60, makePiece('P'), makePiece('.'), makePiece('N'));
+    uciTest.complete(uciPassed);
+
+    Test sanTest("SAN strings: disambiguation, promotions, en passant and castling");
+    const Position rooks("1k6/8/8/8/8/8/4K3/R6R w - - 0 1");
+    const Position kiwipete(cases[1].fen);
+    const Position promotion("8/4P3/8/8/8/8/8/k6K w - - 0 1");
+    const Position enPassant("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+    bool sanPassed = parseSANMove(start, "Nf3") == parseUCIMove(start, "g1f3") && parseSANMove(start, "e4!?") == parseUCIMove(start, "e2e4");
+    sanPassed &= parseSANMove(start, "O-O").isNull() && parseSANMove(start, "Nd4").isNull();
+    sanPassed &= parseSANMove(rooks, "Rd1").isNull() && parseSANMove(rooks, "R1d1").isNull(); // ambiguous
+    sanPassed &= parseSANMove(rooks, "Rad1") == parseUCIMove(rooks, "a1d1") && parseSANMove(rooks, "Rhd1+") == parseUCIMove(rooks, "h1d1");
+    sanPassed &= parseSANMove(kiwipete, "O-O") == parseUCIMove(kiwipete, "e1g1") && parseSANMove(kiwipete, "0-0-0") == parseUCIMove(kiwipete, "e1c1");
+    sanPassed &= parseSANMove(kiwipete, "Bxa6") == parseUCIMove(kiwipete, "e2a6") && parseSANMove(kiwipete, "dxe6") == parseUCIMove(kiwipete, "d5e6");
+    sanPassed &= parseSANMove(promotion, "e8=Q") == parseUCIMove(promotion, "e7e8q") && parseSANMove(promotion, "e8N#") == parseUCIMove(promotion, "e7e8n");
+    sanPassed &= parseSANMove(promotion, "e8").isNull();
+    sanPassed &= parseSANMove(enPassant, "exd6") == parseUCIMove(enPassant, "e5d6") && parseSANMove(enPassant, "exd6").isEnPassant();
+    sanTest.complete(sanPassed);
+
+    // !-- Generation stages & legality --! //
+    std::vector<Move> everyMove; // moves from all the positions, mostly illegal in the others
+    for (const PerftPosition& perftCase : cases) {
+        Position position(perftCase.fen);
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        everyMove.insert(everyMove.end(), moves.begin(), moves.end());
+    }
+
+    bool splitPassed = true, legalPassed = true, pickerPassed = true;
+    for (const PerftPosition& perftCase : cases) {
+        Position position(perftCase.fen);
+        MoveList all, captures, quiets;
+        generateLegalMoves(position, all);
+        generateLegalMoves<GenType::CAPTURES>(position, captures);
+        generateLegalMoves<GenType::QUIETS>(position, quiets);
+
+        std::vector<Move> both(captures.begin(), captures.end());
+        both.insert(both.end(), quiets.begin(), quiets.end());
+        splitPassed &= sorted(both) == sorted(all);
+        for (const Move& move : captures) splitPassed &= move.isCapture() || move.isEnPassant() || move.isPromotion();
+
+        const std::vector<uint32_t> legal = sorted(all);
+        for (const Move& move : everyMove) {
+            legalPassed &= isLegal(position, move) == std::binary_search(legal.begin(), legal.end(), move.hash());
+        }
+
+        // TT move: the last legal move, killers: a quiet move and a move from another position
+        const Move ttMove = all.back();
+        const Move killer = quiets.empty() ? Move() : quiets.front();
+        MovePicker picker(position, ttMove, killer, everyMove.front());
+        std::vector<Move> picked;
+        for (Move move = picker.next(); !move.isNull(); move = picker.next()) picked.push_back(move);
+        pickerPassed &= !picked.empty() && picked.front() == ttMove;
+        pickerPassed &= sorted(picked) == legal; // same moves, no duplicates
+        pickerPassed &= picker.getStage() == PickerStage::END;
+    }
+
+    // every from / to pair (and promotion) with the pieces of the board, one ply deep, including odd cases:
+    // two column king moves off the castling row, pushes blocked by an enemy piece
+    std::vector<std::string> fens;
+    for (const PerftPosition& perftCase : cases) fens.push_back(perftCase.fen);
+    fens.push_back("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    fens.push_back("r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1");
+    fens.push_back("4k3/8/3p4/3P4/p7/P7/4P3/4K3 w - - 0 1");
+    for (const std::string& fen : fens) {
+        Position root(fen);
+        MoveList rootMoves;
+        generateLegalMoves(root, rootMoves);
+        for (size_t i = 0; i <= rootMoves.size(); ++i) {
+            if (i > 0) root.play(rootMoves[i - 1]);
+            MoveList all;
+            generateLegalMoves(root, all);
+            const std::vector<uint32_t> legal = sorted(all);
+            const Color us = root.getActiveColor();
+            for (Square from = 0; from < 64; ++from) {
+                for (Square to = 0; to < 64; ++to) {
+                    for (const char promotion : {'.', 'N', 'B', 'R', 'Q'}) {
+                        const Piece piece = makePiece(us == Color::WHITE ? promotion : static_cast<char>(std::tolower(promotion)));
+                        const Move move(from, to, root.getPieceAt(from), root.getPieceAt(to), piece);
+                        legalPassed &= isLegal(root, move) == std::binary_search(legal.begin(), legal.end(), move.hash());
+                    }
+                }
+            }
+            if (i > 0) root.unplay(rootMoves[i - 1]);
+        }
+    }
+
+    Test("CAPTURES and QUIETS split ALL").complete(splitPassed);
+    Test("isLegal agrees with the generator, on every from / to pair").complete(legalPassed);
+    Test("Move picker hands out every legal move once, TT move first").complete(pickerPassed);
+
+
+    // !-- Allocations --! //
+    Test allocationTest("No heap allocation while searching the tree");
+    Position position(cases[1].fen);
+    static ButterflyHistory history = {};
+    Position loaded;
+    const size_t allocationsBefore = allocationCount;
+    char fenBuffer[Position::FEN_LENGTH];
+    for (const PerftPosition& perftCase : cases) {
+        loaded.parseFEN(perftCase.fen);
+        loaded.writeFEN(fenBuffer);
+    }
+    perft(position, 3);
+    char buffer[Move::UCI_LENGTH];
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (const Move& move : moves) {
+        parseUCIMove(position, std::string_view(buffer, move.toUCI(buffer)));
+    }
+    for (int i = 0; i < 100; ++i) {
+        MovePicker picker(position, Move(), Move(), Move(), &history);
+        for (Move move = picker.next(); !move.isNull(); move = picker.next()) {
+            position.play(move);
+            position.unplay(move);
+        }
+    }
+    allocationTest.complete(allocationCount == allocationsBefore);
+}
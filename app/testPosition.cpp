@@ -0,0 +1,182 @@
+#include "position.hpp"
+#include "cuckoo.hpp"
+#include "boardUI.hpp"
+#include <tintoretto.hpp>
+#include <vector>
+#include <algorithm>
+
+/**
+ * Builds the move from its uci string, reading the pieces on the board.
+ */
+Move moveFromString(const Position& position, const std::string& str) {
+    Square from = (str[1] - '1') * 8 + (str[0] - 'a');
+    Square to = (str[3] - '1') * 8 + (str[2] - 'a');
+    Piece piece = position.getPieceAt(from);
+    Piece promotion = makePiece(Color::WHITE, Figure::EMPTY);
+    if (str.size() == 5) {
+        promotion = makePiece(getColor(piece), getFigure(makePiece(str[4])));
+    }
+    return Move(from, to, piece, position.getPieceAt(to), promotion);
+}
+
+/**
+ * Same zobrist key and partial keys
+ */
+bool sameKeys(const Position& a, const Position& b) {
+    return a.getZobristKey() == b.getZobristKey() && a.getPawnKey() == b.getPawnKey() && a.getMaterialKey() == b.getMaterialKey()
+        && a.getNonPawnKey(Color::WHITE) == b.getNonPawnKey(Color::WHITE) && a.getNonPawnKey(Color::BLACK) == b.getNonPawnKey(Color::BLACK);
+}
+
+int main() {
+    const std::vector<std::string> game = {
+        "e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "g8f6", "b1c3", "a7a5", "e1g1", "h7h6",
+        "d2d4", "h8h7", "d4e5", "d7d5", "e5d6", "a5a4", "d6c7", "a4a3", "c7d8r", "e8e7",
+        "d8c8", "c6a5", "d1d8"
+    };
+
+    Test fen_test("Testing FEN in-out");
+    std::string fen = "r1RQ1b2/1p2kppr/5n1p/n7/2B1P3/p1N2N2/PPP2PPP/R1B2RK1 b - - 2 12";
+    Position position(fen);
+    fen_test.complete(position.toFEN() == fen && Position().toFEN() == Position::startpos);
+
+    Test malformed_test("Malformed FENs are reported without exceptions");
+    Position parsed;
+    const std::vector<std::pair<std::string, FENError>> malformed = {
+        {"", FENError::FIELDS},
+        {"8/8/8/8/8/8/8/8 w", FENError::FIELDS},
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq -", FENError::BOARD},
+        {"rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -", FENError::BOARD},
+        {"rnbqkbnr/ppppxppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -", FENError::BOARD},
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR/8 w KQkq -", FENError::BOARD},
+        {"rnbqqbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -", FENError::KINGS},
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq -", FENError::ACTIVE_COLOR},
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkx -", FENError::CASTLING},
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e4", FENError::EN_PASSANT},
+        {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq e3", FENError::EN_PASSANT}, // black's square, white to move
+        {"rnbqkbnr/pppp1ppp/8/4p3/8/8/PPPPPPPP/RNBQKBNR b KQkq e6", FENError::EN_PASSANT},
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq d6", FENError::EN_PASSANT}, // no pawn went through d6
+        {"rnbqkbnr/ppp1pppp/3p4/3p4/8/8/PPPPPPPP/RNBQKBNR w KQkq d6", FENError::EN_PASSANT}, // d6 is not empty
+        {"4k3/8/8/8/8/8/8/4K2R w - -", FENError::NONE},
+        {"4k2R/8/8/8/8/8/8/4K3 w - -", FENError::OPPONENT_IN_CHECK}, // white could take the king
+        {"4k3/8/8/8/8/8/3p4/4K3 b - -", FENError::OPPONENT_IN_CHECK},
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 one", FENError::CLOCKS},
+    };
+    bool passed = true;
+    for (const auto& [text, error] : malformed) {
+        passed &= parsed.parseFEN(text) == error;
+    }
+    passed &= parsed.parseFEN("  " + fen + "  ") == FENError::NONE && parsed.toFEN() == fen; // same Position, reused
+    passed &= parsed.parseFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm e4;") == FENError::CLOCKS;
+    passed &= parsed.parseFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -") == FENError::NONE && sameKeys(parsed, Position());
+    char buffer[Position::FEN_LENGTH];
+    passed &= std::string(buffer, parsed.writeFEN(buffer)) == Position::startpos;
+    try {
+        parsed.fromFEN("8/8/8/8/8/8/8/8 w - -");
+        passed = false;
+    } catch (const std::invalid_argument&) {}
+    malformed_test.complete(passed);
+
+
+    Test play_test("Testing play against BoardUI");
+    passed = true;
+    Position played;
+    BoardUI board;
+    Message::mute(); // BoardUI is verbose
+    board.fromFEN(BoardUI::startpos);
+    std::vector<Move> moves;
+    for (const std::string& str : game) {
+        Move move = moveFromString(played, str);
+        moves.push_back(move);
+        played.play(move);
+        board.play(str);
+
+        // same pieces on the board, and same key as a position built from scratch
+        std::string playedFen = played.toFEN();
+        std::string boardFen = board.toFEN();
+        passed &= playedFen.substr(0, playedFen.find(' ')) == boardFen.substr(0, boardFen.find(' '));
+        passed &= sameKeys(played, Position(playedFen));
+    }
+    Message::unmute();
+    play_test.complete(passed && played.toFEN() == fen);
+
+
+    Test unplay_test("Testing unplay");
+    uint64_t finalKey = played.getZobristKey();
+    for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+        played.unplay(*it);
+    }
+    unplay_test.complete(played.toFEN() == Position::startpos && played.getZobristKey() == Position().getZobristKey() && finalKey != played.getZobristKey());
+
+
+    Test special_test("Testing en passant, castle and promotion hashing");
+    passed = true;
+    const std::vector<std::pair<std::string, std::string>> specials = {
+        {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", "e5f6"}, // en passant
+        {"r3k2r/pppppppp/8/8/8/8/PPPPPPPP/R3K2R w KQkq - 0 1", "e1c1"}, // castle queen side
+        {"r3k2r/pppppppp/8/8/8/8/PPPPPPPP/R3K2R b KQkq - 0 1", "e8g8"}, // castle king side
+        {"1n2k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7b8q"}, // capture promotion
+    };
+    for (const auto& [start, str] : specials) {
+        Position special(start);
+        Move move = moveFromString(special, str);
+        special.play(move);
+        passed &= sameKeys(special, Position(special.toFEN()));
+        special.unplay(move);
+        passed &= special.toFEN() == start && sameKeys(special, Position(start));
+    }
+    special_test.complete(passed);
+
+
+    Test zobrist_test("Testing that zobrist keys are fixed and distinct");
+    std::vector<uint64_t> keys(&ZOBRIST.pieceKeys[0][0][0], &ZOBRIST.pieceKeys[0][0][0] + 2 * 6 * 64);
+    keys.insert(keys.end(), std::begin(ZOBRIST.castlingKeys), std::end(ZOBRIST.castlingKeys));
+    keys.insert(keys.end(), std::begin(ZOBRIST.enPassantKeys), std::end(ZOBRIST.enPassantKeys));
+    keys.push_back(ZOBRIST.activeColorKey);
+    std::sort(keys.begin(), keys.end());
+    passed = std::adjacent_find(keys.begin(), keys.end()) == keys.end() && keys.front() != 0;
+    zobrist_test.complete(passed && Position().getZobristKey() == 0xc5a1a117bb19e19cULL); // same value in every build
+
+
+    Test partial_keys_test("Testing pawn, non pawn and material keys");
+    Position start, afterE4("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+    passed = start.getMaterialKey() == afterE4.getMaterialKey() && start.getPawnKey() != afterE4.getPawnKey();
+    passed &= start.getNonPawnKey(Color::WHITE) == afterE4.getNonPawnKey(Color::WHITE);
+    passed &= Position("4k3/8/8/8/8/8/8/3QK3 w - - 0 1").getMaterialKey() != Position("3qk3/8/8/8/8/8/8/4K3 w - - 0 1").getMaterialKey(); // colors matter
+    passed &= Position("4k3/8/8/8/8/8/8/3QK3 w - - 0 1").getMaterialKey() == Position("4k3/8/8/8/8/8/8/4KQ2 b - - 0 1").getMaterialKey(); // squares do not
+    partial_keys_test.complete(passed);
+
+
+    Test repetition_test("Testing repetitions");
+    Position shuffled;
+    auto playAll = [&](const std::vector<std::string>& strs) {
+        for (const std::string& str : strs) shuffled.play(moveFromString(shuffled, str));
+    };
+    playAll({"g1f3", "g8f6", "f3g1"});
+    passed = !shuffled.isRepetition() && shuffled.hasUpcomingRepetition(4) && !shuffled.hasUpcomingRepetition(0); // f6g8 repeats startpos
+    playAll({"f6g8"});
+    passed &= shuffled.isRepetition() && !shuffled.isThreefoldRepetition();
+    playAll({"g1f3", "g8f6", "f3g1"});
+    passed &= shuffled.hasUpcomingRepetition(0); // the target position already occurred twice
+    playAll({"f6g8"});
+    passed &= shuffled.isThreefoldRepetition();
+    playAll({"e2e3", "e7e6", "g1f3", "g8f6", "f3g1", "f6g8"}); // the pawn moves hide what came before
+    passed &= shuffled.isRepetition() && !shuffled.isThreefoldRepetition();
+    playAll({"f1e2", "f8e7", "e2d3"});
+    passed &= !shuffled.hasUpcomingRepetition(10); // e7f8 does not give back an earlier position: the white bishop moved on
+    repetition_test.complete(passed && CUCKOO.count == 3668); // every reversible (piece, from, to), from < to
+
+
+    Test adapter_test("Testing the virtual adapter");
+    Position adapted;
+    PositionAdapter<Position> adapter(adapted);
+    PositionInterface& any = adapter;
+    Move move = moveFromString(adapted, "e2e4");
+    any.play(move);
+    passed = any.getActiveColor() == Color::BLACK && getFigure(any.getPieceAt(28)) == Figure::PAWN && any.toFEN() == adapted.toFEN();
+    any.unplay(move);
+    adapter_test.complete(passed && any.getZobristKey() == Position().getZobristKey());
+
+    Message::print("Final position of the game, built from FEN:");
+    board.fromFEN(position.toFEN());
+    std::cout << board << std::endl;
+}
@@ -0,0 +1,62 @@
+#include "see.hpp"
+#include "movegen.hpp"
+#include "perft.hpp"
+#include <tintoretto.hpp>
+#include <vector>
+
+struct SEECase {
+    std::string fen;
+    std::string move;
+    int32_t value;
+};
+
+int main() {
+    Test known_test("Testing exchanges with known values");
+    const std::vector<SEECase> cases = {
+        {"1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", 100}, // undefended pawn
+        {"1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", -220}, // knight for a pawn
+        {"4k3/8/2p5/3p4/4P3/8/8/4K3 w - - 0 1", "e4d5", 0}, // pawn for pawn
+        {"4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1", "d2d5", -800},
+        {"4k3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", "d2d5", 100}, // the rook on d1 x-rays through d2
+        {"4k3/3r4/8/3p4/8/8/8/3RK3 w - - 0 1", "d1d5", -400},
+        {"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 100}, // en passant
+        {"3r3k/4P3/8/8/8/8/8/4K3 w - - 0 1", "e7d8q", 1300}, // rook and promotion
+        {"3r3k/4P3/8/8/8/8/8/4K3 w - - 0 1", "e7e8q", -100}, // the new queen is taken, the rook is not
+        {"4k3/8/8/8/8/8/3p4/4K3 w - - 0 1", "e1d2", 100}, // undefended: the king takes
+        {"r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "e1g1", 0}, // castling
+    };
+    bool passed = true;
+    for (const SEECase& seeCase : cases) {
+        const Position position(seeCase.fen);
+        const Move move = parseUCIMove(position, seeCase.move);
+        passed &= !move.isNull() && see(position, move) == seeCase.value;
+        passed &= seeGE(position, move, seeCase.value) && !seeGE(position, move, seeCase.value + 1);
+    }
+    known_test.complete(passed);
+
+    Test threshold_test("Testing seeGE against see, one ply deep");
+    passed = true;
+    size_t captures = 0;
+    auto check = [&](const Position& position) {
+        MoveList moves;
+        generateLegalMoves<GenType::CAPTURES>(position, moves);
+        for (const Move& move : moves) {
+            const int32_t value = see(position, move);
+            for (int32_t threshold = -1000; threshold <= 1000; threshold += 10) {
+                passed &= seeGE(position, move, threshold) == (value >= threshold);
+            }
+            captures++;
+        }
+    };
+    for (const PerftPosition& perftCase : PERFT_SUITE) {
+        Position position(perftCase.fen);
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        for (const Move& move : moves) {
+            position.play(move);
+            check(position);
+            position.unplay(move);
+        }
+    }
+    threshold_test.complete(passed && captures > 500);
+}
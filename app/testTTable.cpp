@@ -0,0 +1,166 @@
+#include "ttableBase.hpp"
+#include "movegen.hpp"
+#include <tintoretto.hpp>
+#include <random>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+/**
+ * Entry content derived from the key, so that a reader can tell a corrupted entry from a good one
+ */
+struct Expected {
+    PackedMove move;
+    int16_t score;
+    int16_t eval;
+    int depth;
+
+    Expected(uint64_t key)
+        : move(static_cast<uint16_t>(key >> 32 | 1)), score(static_cast<int16_t>(key >> 16)), eval(static_cast<int16_t>(key >> 48)),
+          depth(static_cast<int>(key >> 40 & 31)) {}
+
+    bool matches(const TTData& data) const {
+        return data.move == move && data.score == score && data.eval == eval && data.depth == depth && data.bound == Bound::EXACT;
+    }
+};
+
+int main() {
+    Test store_test("Testing store and probe");
+    TranspositionTable table(1);
+    const Position position;
+    const uint64_t key = position.getZobristKey();
+    const PackedMove e2e4(parseUCIMove(position, "e2e4"));
+    TTData data;
+    bool passed = table.getBucketCount() == 1024 * 1024 / 64 && !table.probe(key, data);
+    table.store(key, 5, Bound::LOWER, 35, 10, e2e4);
+    passed &= table.probe(key, data) && data.move == e2e4 && data.score == 35 && data.eval == 10 && data.depth == 5 && data.bound == Bound::LOWER;
+    table.store(key, -3, Bound::UPPER, -20, 10, PackedMove()); // shallower, same search: only the move could change
+    passed &= table.probe(key, data) && data.depth == 5 && data.move == e2e4;
+    table.store(key, 2, Bound::EXACT, 12, 10, PackedMove()); // exact: replaces, the move is kept
+    passed &= table.probe(key, data) && data.depth == 2 && data.bound == Bound::EXACT && data.move == e2e4;
+    table.store(key, -7, Bound::UPPER, 0, 0, PackedMove());
+    passed &= table.probe(key, data) && data.depth == 2; // deepest entry of this search kept
+    table.clear();
+    passed &= !table.probe(key, data);
+    store_test.complete(passed);
+
+    Test replace_test("Testing depth and age replacement");
+    // keys with the same high bits fall in the same bucket, the low bits tell them apart
+    auto keyOf = [](uint64_t i) {return 0xABCD000000000000ULL | i;};
+    for (uint64_t i = 1; i <= 5; ++i) table.store(keyOf(i), static_cast<int>(i), Bound::EXACT, 0, 0, PackedMove());
+    table.store(keyOf(6), 4, Bound::EXACT, 0, 0, PackedMove()); // the bucket is full: depth 1 goes
+    passed = !table.probe(keyOf(1), data) && table.probe(keyOf(2), data) && table.probe(keyOf(6), data);
+    table.newSearch();
+    table.newSearch();
+    table.store(keyOf(7), 1, Bound::EXACT, 0, 0, PackedMove()); // everything is two searches old: the shallowest goes
+    passed &= table.probe(keyOf(7), data) && !table.probe(keyOf(2), data) && table.probe(keyOf(6), data);
+    table.store(keyOf(8), 1, Bound::EXACT, 0, 0, PackedMove()); // depth 3 two searches ago is worth less than depth 1 now
+    passed &= table.probe(keyOf(8), data) && !table.probe(keyOf(3), data) && table.probe(keyOf(7), data);
+    replace_test.complete(passed);
+
+    Test full_test("Testing hashfull and generation wrap");
+    table.clear();
+    std::mt19937_64 rng(7);
+    for (size_t i = 0; i < table.getEntryCount() * 4; ++i) table.store(rng(), 1, Bound::LOWER, 0, 0, PackedMove());
+    passed = table.getHashfull() == 1000;
+    for (int i = 0; i < 32; ++i) table.newSearch(); // 32 searches later the generation is back, not the entries' age
+    passed &= table.getHashfull() == 1000;
+    table.newSearch();
+    passed &= table.getHashfull() == 0;
+    full_test.complete(passed);
+
+    Test resize_test("Testing resize, parallel clear and allocation failure");
+    table.resize(3, 4); // not a power of 2
+    passed = table.getBucketCount() == 3 * 1024 * 1024 / 64 && !table.probe(key, data);
+    table.store(key, 5, Bound::LOWER, 35, 10, e2e4);
+    passed &= table.probe(key, data) && data.move == e2e4;
+    table.clear(4);
+    passed &= !table.probe(key, data) && table.getHashfull() == 0;
+    try {
+        table.resize(size_t(1) << 40); // an exabyte
+        passed = false;
+    } catch (const std::bad_alloc&) {
+        passed &= table.getBucketCount() == TranspositionTable::FALLBACK_MEGABYTES * 1024 * 1024 / 64 && !table.probe(key, data);
+        table.store(key, 5, Bound::LOWER, 35, 10, e2e4);
+        passed &= table.probe(key, data) && data.move == e2e4; // still usable
+    }
+    table.resize(3);
+    const HashMemory small(1000), large(5 << 20);
+    passed &= reinterpret_cast<uintptr_t>(small.get()) % 64 == 0 && small.size() >= 1000;
+    passed &= reinterpret_cast<uintptr_t>(large.get()) % 64 == 0 && large.size() >= (5 << 20);
+    Message::print(std::string("Huge pages: ") + (large.usesHugePages() ? "yes" : "no"));
+    resize_test.complete(passed);
+
+    Test snapshot_test("Testing snapshot save and load");
+    const std::string path = (std::filesystem::temp_directory_path() / "chess_tt_snapshot.bin").string();
+    table.clear();
+    table.newSearch();
+    table.store(key, 5, Bound::LOWER, 35, 10, e2e4);
+    table.save(path);
+    passed = std::filesystem::file_size(path) == 64 + table.getBucketCount() * 64;
+    table.clear();
+    table.load(path);
+    passed &= table.probe(key, data) && data.move == e2e4 && data.score == 35 && data.depth == 5;
+    auto rejected = [&](const std::string& file) {
+        try {
+            table.load(file);
+            return false;
+        } catch (const std::runtime_error& error) {
+            Message::print(error.what());
+            return table.probe(key, data); // untouched
+        }
+    };
+    TranspositionTable other(1);
+    other.save(path); // 1 MB, the table is 3 MB
+    passed &= rejected(path);
+    table.save(path);
+    std::filesystem::resize_file(path, 64 + 64 * 100);
+    passed &= rejected(path);
+    std::ofstream(path) << "not a snapshot, but long enough to have a header: 64 bytes and more, more, more";
+    passed &= rejected(path) && rejected(path + ".missing");
+    std::filesystem::remove(path);
+    auto saveFails = [&](const std::string& file) {
+        try {
+            table.save(file);
+            return false;
+        } catch (const std::runtime_error& error) {
+            Message::print(error.what());
+            return !std::filesystem::exists(file + ".tmp"); // nothing left behind
+        }
+    };
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "chess_tt_snapshot_dir";
+    std::filesystem::create_directories(directory / "busy");
+    passed &= saveFails((directory / "missing" / "hash.bin").string()); // cannot create the file
+    passed &= saveFails(directory.string()); // written, but cannot be renamed over a directory
+    std::filesystem::remove_all(directory);
+    snapshot_test.complete(passed);
+
+    Test stress_test("Testing concurrent stores and probes, without locks");
+    TranspositionTable shared(1); // small: the threads keep writing over each other
+    std::vector<uint64_t> keys(1 << 16);
+    for (uint64_t& k : keys) k = rng();
+    std::atomic<uint64_t> hits{0}, corrupted{0};
+    auto worker = [&](unsigned seed) {
+        std::mt19937_64 local(seed);
+        uint64_t localHits = 0, localCorrupted = 0;
+        for (int i = 0; i < 500000; ++i) {
+            const uint64_t k = keys[local() % keys.size()];
+            const Expected expected(k);
+            if (local() % 2) {
+                shared.store(k, expected.depth, Bound::EXACT, expected.score, expected.eval, expected.move);
+            } else if (TTData found; shared.probe(k, found)) {
+                localHits++;
+                localCorrupted += !expected.matches(found);
+            }
+        }
+        hits += localHits;
+        corrupted += localCorrupted;
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < 8; ++i) pool.emplace_back(worker, i);
+    for (std::thread& thread : pool) thread.join();
+    Message::print("Hits: " + std::to_string(hits.load()) + ", corrupted: " + std::to_string(corrupted.load()));
+    stress_test.complete(hits > 0 && corrupted == 0);
+}
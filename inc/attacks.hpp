@@ -0,0 +1,256 @@
+#ifndef ATTACKS_HPP
+#define ATTACKS_HPP
+
+/**
+ * Attack tables, so that move generation never walks along rays.
+ *
+ * Leapers (knight, king, pawns) and the square relations (between, line) only depend on the squares,
+ * so they are computed at compile time and cost nothing at startup.
+ * Sliders (bishop, rook, queen) depend on the occupancy and use magic bitboards: the relevant blockers are
+ * multiplied by a magic number, and the top bits of the product index a table of precomputed attacks.
+ * The magic numbers themselves are hardcoded in src/attacks.cpp (finding them is the slow part), so the
+ * startup cost is a single pass filling the ~100k table entries.
+ * On x86 CPUs with BMI2, the PEXT instruction gathers the relevant blockers into a perfect index directly,
+ * which is faster than the multiplication. The backend is picked at startup from CPUID, magic being the
+ * fallback; both share the same tables. The lookups are templates on the backend: the hot code (move
+ * generation, legality, SEE, perft) is a template on it too and reads sliderBackend once at its entry point,
+ * never per lookup. The lookups without template argument dispatch each time, for the cold code.
+ * The slider tables are filled during static initialization of src/attacks.cpp: do not query them
+ * from other static initializers.
+ */
+
+#include "bitboard.hpp"
+#include <array>
+
+
+// --------------------------- //
+// !-- Compile time tables --! //
+// --------------------------- //
+
+/**
+ * Square reached from (row, col) with the given offset, or 64 if it falls off the board
+ */
+inline constexpr Square offsetSquare(Square square, int dRow, int dCol) {
+    int row = static_cast<int>(getRow(square)) + dRow;
+    int col = static_cast<int>(getCol(square)) + dCol;
+    return (row < 0 || row > 7 || col < 0 || col > 7) ? 64 : static_cast<Square>(row * 8 + col);
+}
+
+template<size_t N>
+inline constexpr std::array<Bitboard, 64> leaperTable(const int (&offsets)[N][2]) {
+    std::array<Bitboard, 64> table = {};
+    for (Square square = 0; square < 64; ++square) {
+        for (size_t i = 0; i < N; ++i) {
+            Square target = offsetSquare(square, offsets[i][0], offsets[i][1]);
+            if (target < 64) table[square] |= squareBB(target);
+        }
+    }
+    return table;
+}
+
+inline constexpr int KNIGHT_OFFSETS[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+inline constexpr int KING_OFFSETS[8][2] = {{1, -1}, {1, 0}, {1, 1}, {0, -1}, {0, 1}, {-1, -1}, {-1, 0}, {-1, 1}};
+inline constexpr int WHITE_PAWN_OFFSETS[2][2] = {{1, -1}, {1, 1}};
+inline constexpr int BLACK_PAWN_OFFSETS[2][2] = {{-1, -1}, {-1, 1}};
+
+/**
+ * between[a][b]: squares strictly between a and b, line[a][b]: the whole line through a and b, edge to edge.
+ * Both are empty when a and b are not on a common row, column or diagonal.
+ */
+struct SquarePairTables {
+    Bitboard between[64][64] = {};
+    Bitboard line[64][64] = {};
+};
+
+inline constexpr SquarePairTables squarePairTables() {
+    SquarePairTables tables;
+    for (Square from = 0; from < 64; ++from) {
+        for (int direction = 0; direction < 8; ++direction) {
+            const int dRow = KING_OFFSETS[direction][0];
+            const int dCol = KING_OFFSETS[direction][1];
+
+            // the full line through 'from' in this direction (both ways)
+            Bitboard fullLine = squareBB(from);
+            for (int sign = -1; sign <= 1; sign += 2) {
+                for (Square sq = offsetSquare(from, sign * dRow, sign * dCol); sq < 64; sq = offsetSquare(sq, sign * dRow, sign * dCol)) {
+                    fullLine |= squareBB(sq);
+                }
+            }
+
+            Bitboard ray = 0;
+            for (Square to = offsetSquare(from, dRow, dCol); to < 64; to = offsetSquare(to, dRow, dCol)) {
+                tables.between[from][to] = ray;
+                tables.line[from][to] = fullLine;
+                ray |= squareBB(to);
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr std::array<Bitboard, 64> KNIGHT_ATTACKS = leaperTable(KNIGHT_OFFSETS);
+inline constexpr std::array<Bitboard, 64> KING_ATTACKS = leaperTable(KING_OFFSETS);
+inline constexpr std::array<Bitboard, 64> PAWN_ATTACKS[2] = { // indexed by getColorIndex
+    leaperTable(WHITE_PAWN_OFFSETS),
+    leaperTable(BLACK_PAWN_OFFSETS),
+};
+inline constexpr SquarePairTables SQUARE_PAIRS = squarePairTables();
+
+
+// --------------------- //
+// !-- Magic sliders --! //
+// --------------------- //
+
+#if defined(__x86_64__)
+#define CHESS_HAS_PEXT 1
+#else
+#define CHESS_HAS_PEXT 0
+#endif
+
+enum class SliderBackend : uint32_t {
+    MAGIC = 0,
+    PEXT = 1,
+};
+
+extern SliderBackend sliderBackend; // do not write directly, see initSliders
+
+inline bool usesPextSliders() {
+    return CHESS_HAS_PEXT && sliderBackend == SliderBackend::PEXT;
+}
+
+/**
+ * PEXT if the CPU supports BMI2, MAGIC otherwise
+ */
+SliderBackend detectSliderBackend();
+
+/**
+ * (Re)fills the slider tables for the given backend. Done once at startup with detectSliderBackend(),
+ * call it again only to compare backends, never while other threads are looking up attacks.
+ * @throws std::runtime_error if PEXT is requested on a CPU without BMI2.
+ */
+void initSliders(SliderBackend backend);
+
+/**
+ * Parallel bits extract: packs the bits of src selected by mask into the low bits of the result.
+ * Written in inline assembly so that the rest of the program does not need to be compiled with -mbmi2;
+ * only call it when usesPextSliders().
+ */
+inline uint64_t pext(uint64_t src, uint64_t mask) {
+#if CHESS_HAS_PEXT
+    uint64_t result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(src), "rm"(mask));
+    return result;
+#else
+    (void)src; (void)mask;
+    return 0;
+#endif
+}
+
+struct Magic {
+    Bitboard mask; // relevant blockers: the rays from the square, without the board edges
+    uint64_t magic;
+    Bitboard* attacks; // this square's slice of the shared attack table
+    uint32_t shift; // 64 - popCount(mask)
+
+    template<SliderBackend Backend>
+    uint32_t index(Bitboard occupied) const {
+        if constexpr (Backend == SliderBackend::PEXT) {
+            return static_cast<uint32_t>(pext(occupied, mask));
+        } else {
+            return static_cast<uint32_t>(((occupied & mask) * magic) >> shift);
+        }
+    }
+};
+
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+/**
+ * Reference implementation walking along the rays, used to fill the magic tables (and to test them).
+ */
+Bitboard slidingAttacks(Square square, Bitboard occupied, bool isRook);
+
+
+// ------------------ //
+// !-- Lookup API --! //
+// ------------------ //
+
+inline Bitboard knightAttacks(Square square) {
+    return KNIGHT_ATTACKS[square];
+}
+
+inline Bitboard kingAttacks(Square square) {
+    return KING_ATTACKS[square];
+}
+
+/**
+ * Squares attacked by a pawn of the given color standing on square
+ */
+inline Bitboard pawnAttacks(Color color, Square square) {
+    return PAWN_ATTACKS[getColorIndex(color)][square];
+}
+
+template<SliderBackend Backend>
+inline Bitboard bishopAttacks(Square square, Bitboard occupied) {
+    const Magic& m = bishopMagics[square];
+    return m.attacks[m.index<Backend>(occupied)];
+}
+
+template<SliderBackend Backend>
+inline Bitboard rookAttacks(Square square, Bitboard occupied) {
+    const Magic& m = rookMagics[square];
+    return m.attacks[m.index<Backend>(occupied)];
+}
+
+template<SliderBackend Backend>
+inline Bitboard queenAttacks(Square square, Bitboard occupied) {
+    return bishopAttacks<Backend>(square, occupied) | rookAttacks<Backend>(square, occupied);
+}
+
+/**
+ * Attacks of any non pawn figure
+ */
+template<SliderBackend Backend>
+inline Bitboard attacksOf(Figure figure, Square square, Bitboard occupied) {
+    switch (figure) {
+        case Figure::KNIGHT: return knightAttacks(square);
+        case Figure::BISHOP: return bishopAttacks<Backend>(square, occupied);
+        case Figure::ROOK:   return rookAttacks<Backend>(square, occupied);
+        case Figure::QUEEN:  return queenAttacks<Backend>(square, occupied);
+        case Figure::KING:   return kingAttacks(square);
+        default: return 0;
+    }
+}
+
+/**
+ * Same, with the backend read at each call: for code outside the hot paths
+ */
+inline Bitboard bishopAttacks(Square square, Bitboard occupied) {
+    return usesPextSliders() ? bishopAttacks<SliderBackend::PEXT>(square, occupied) : bishopAttacks<SliderBackend::MAGIC>(square, occupied);
+}
+
+inline Bitboard rookAttacks(Square square, Bitboard occupied) {
+    return usesPextSliders() ? rookAttacks<SliderBackend::PEXT>(square, occupied) : rookAttacks<SliderBackend::MAGIC>(square, occupied);
+}
+
+inline Bitboard queenAttacks(Square square, Bitboard occupied) {
+    return usesPextSliders() ? queenAttacks<SliderBackend::PEXT>(square, occupied) : queenAttacks<SliderBackend::MAGIC>(square, occupied);
+}
+
+inline Bitboard attacksOf(Figure figure, Square square, Bitboard occupied) {
+    return usesPextSliders() ? attacksOf<SliderBackend::PEXT>(figure, square, occupied) : attacksOf<SliderBackend::MAGIC>(figure, square, occupied);
+}
+
+inline Bitboard between(Square from, Square to) {
+    return SQUARE_PAIRS.between[from][to];
+}
+
+inline Bitboard line(Square from, Square to) {
+    return SQUARE_PAIRS.line[from][to];
+}
+
+inline bool aligned(Square a, Square b, Square c) {
+    return line(a, b) & squareBB(c);
+}
+
+#endif
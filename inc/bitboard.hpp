@@ -0,0 +1,56 @@
+#ifndef BITBOARD_HPP
+#define BITBOARD_HPP
+
+/**
+ * A bitboard is a set of squares packed in 64 bits: bit i is set <=> square i is in the set.
+ * Squares follow move.hpp: a1 = 0, h1 = 7, a8 = 56, h8 = 63.
+ */
+
+#include "move.hpp"
+#include <cstdint>
+
+
+using Bitboard = uint64_t;
+
+inline constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+inline constexpr Bitboard FILE_H = FILE_A << 7;
+inline constexpr Bitboard RANK_1 = 0xFFULL;
+inline constexpr Bitboard RANK_8 = RANK_1 << 56;
+
+inline constexpr Bitboard squareBB(Square square) {
+    return 1ULL << square;
+}
+
+inline constexpr Bitboard fileBB(Square square) {
+    return FILE_A << getCol(square);
+}
+
+inline constexpr Bitboard rankBB(Square square) {
+    return RANK_1 << (8 * getRow(square));
+}
+
+inline int popCount(Bitboard bb) {
+    return __builtin_popcountll(bb);
+}
+
+/**
+ * Least significant square of a non empty bitboard
+ */
+inline Square lsb(Bitboard bb) {
+    return static_cast<Square>(__builtin_ctzll(bb));
+}
+
+/**
+ * Returns the least significant square and removes it from the bitboard
+ */
+inline Square popLsb(Bitboard& bb) {
+    Square square = lsb(bb);
+    bb &= bb - 1; // clears the lowest bit
+    return square;
+}
+
+inline constexpr bool moreThanOne(Bitboard bb) {
+    return bb & (bb - 1);
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef CUCKOO_HPP
+#define CUCKOO_HPP
+
+/**
+ * Cuckoo tables of the reversible moves, for Position::hasUpcomingRepetition.
+ *
+ * A reversible move of a non pawn piece changes the zobrist key by pieceKeys[piece][from] ^ pieceKeys[piece][to]
+ * ^ activeColorKey, whatever the rest of the board. So "is there a move from the current position to this
+ * older one" is "is the difference of their keys one of these values", a lookup in a table of the 3668
+ * (piece, square, square) combinations reachable on an empty board. Cuckoo hashing keeps it at two probes:
+ * every key sits in one of its two slots, H1 or H2.
+ * The table only depends on the zobrist keys, so it is built at compile time too.
+ */
+
+#include "positionBase.hpp"
+#include "attacks.hpp"
+
+
+struct CuckooTables {
+    static constexpr uint32_t SIZE = 8192;
+
+    uint64_t keys[SIZE] = {}; // 0 --> empty slot
+    uint16_t moves[SIZE] = {}; // from << 6 | to, with from < to (the piece may go both ways)
+    uint32_t count = 0;
+
+    static constexpr uint32_t H1(uint64_t key) {return key & 0x1FFF;}
+    static constexpr uint32_t H2(uint64_t key) {return (key >> 16) & 0x1FFF;}
+
+    static constexpr bool reaches(Figure figure, Square from, Square to) {
+        const int dRow = static_cast<int>(getRow(to)) - static_cast<int>(getRow(from));
+        const int dCol = static_cast<int>(getCol(to)) - static_cast<int>(getCol(from));
+        const bool diagonal = dRow == dCol || dRow == -dCol;
+        const bool orthogonal = dRow == 0 || dCol == 0;
+        switch (figure) {
+            case Figure::KNIGHT: return KNIGHT_ATTACKS[from] & squareBB(to);
+            case Figure::BISHOP: return diagonal;
+            case Figure::ROOK:   return orthogonal;
+            case Figure::QUEEN:  return diagonal || orthogonal;
+            case Figure::KING:   return KING_ATTACKS[from] & squareBB(to);
+            default: return false;
+        }
+    }
+
+    static constexpr CuckooTables generate() {
+        CuckooTables tables;
+        for (uint32_t color = 0; color < 2; ++color) {
+            for (Figure figure : {Figure::KNIGHT, Figure::BISHOP, Figure::ROOK, Figure::QUEEN, Figure::KING}) {
+                const uint32_t figureIndex = static_cast<uint32_t>(figure) - 1;
+                for (Square from = 0; from < 64; ++from) {
+                    for (Square to = from + 1; to < 64; ++to) {
+                        if (!reaches(figure, from, to)) continue;
+
+                        uint64_t key = ZOBRIST.pieceKeys[color][figureIndex][from] ^ ZOBRIST.pieceKeys[color][figureIndex][to] ^ ZOBRIST.activeColorKey;
+                        uint16_t move = static_cast<uint16_t>(from << 6 | to);
+                        uint32_t slot = H1(key);
+                        while (true) { // kick the previous occupant to its other slot, until one lands in an empty slot
+                            const uint64_t kickedKey = tables.keys[slot];
+                            const uint16_t kickedMove = tables.moves[slot];
+                            tables.keys[slot] = key;
+                            tables.moves[slot] = move;
+                            if (kickedMove == 0) break;
+                            key = kickedKey;
+                            move = kickedMove;
+                            slot = slot == H1(key) ? H2(key) : H1(key);
+                        }
+                        tables.count++;
+                    }
+                }
+            }
+        }
+        return tables;
+    }
+
+    /**
+     * Slot holding the key, or SIZE if the key is not a reversible move
+     */
+    constexpr uint32_t find(uint64_t key) const {
+        if (keys[H1(key)] == key) return H1(key);
+        if (keys[H2(key)] == key) return H2(key);
+        return SIZE;
+    }
+};
+
+inline constexpr CuckooTables CUCKOO = CuckooTables::generate();
+
+
+#endif
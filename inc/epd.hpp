@@ -0,0 +1,97 @@
+#ifndef EPD_HPP
+#define EPD_HPP
+
+/**
+ * Loading of large EPD / FEN files (tuning sets, test suites).
+ *
+ * The file is never read into a buffer: it is mapped window by window (a fixed amount of address space,
+ * the pages are dropped once the window is done), each window is cut into line aligned chunks, and the
+ * chunks are parsed in parallel, one thread and one batch per chunk. The batches are handed to the
+ * consumer in file order, so that files larger than the memory can be streamed through.
+ *
+ * A line is a FEN (clocks optional), or the 4 first FEN fields followed by EPD operations:
+ *      r1b1kb1r/ppp2ppp/2n5/8/2BqN3/8/PPP2PPP/R1BQK2R w KQkq - bm Nxd4; id "test.001"; c0 "a comment";
+ * bm (best moves) and am (moves to avoid) are read in SAN or UCI format, id and c0 are kept as text, the
+ * other operations are ignored. Empty lines and lines starting with '#' are skipped, malformed lines are
+ * counted and skipped.
+ */
+
+#include "position.hpp"
+#include "move.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+
+/**
+ * One line of the file
+ */
+struct EPDRecord {
+    static constexpr size_t MAX_MOVES = 4; // per operation, the others are dropped
+    static constexpr uint32_t NO_TEXT = UINT32_MAX;
+
+    PackedPosition position;
+    PackedMove bestMoves[MAX_MOVES] = {}; // null moves after the last one
+    PackedMove avoidMoves[MAX_MOVES] = {};
+    uint32_t id = NO_TEXT; // offsets in EPDBatch::text
+    uint32_t comment = NO_TEXT;
+};
+
+/**
+ * Records parsed from a chunk of the file, with their text. Reused from a window to the next: clear keeps
+ * the capacity.
+ */
+class EPDBatch {
+    public:
+        std::vector<EPDRecord> records;
+        std::string text; // ids and comments, each one followed by a '\0'
+        size_t errors = 0; // malformed lines
+
+        void clear() {
+            records.clear();
+            text.clear();
+            errors = 0;
+        }
+
+        std::string_view getId(const EPDRecord& record) const {return getText(record.id);}
+        std::string_view getComment(const EPDRecord& record) const {return getText(record.comment);}
+
+        /**
+         * Appends the records of the other batch, moving their text offsets along
+         */
+        void append(const EPDBatch& other);
+
+        /**
+         * Parses one line and appends its record. position is scratch space, reused from a line to the next.
+         * Returns false if the line is malformed (and counts it), true otherwise, skipped lines included.
+         */
+        bool parseLine(std::string_view line, Position& position);
+
+    private:
+        std::string_view getText(uint32_t offset) const {
+            return offset == EPDRecord::NO_TEXT ? std::string_view() : std::string_view(text.c_str() + offset);
+        }
+
+        uint32_t addText(std::string_view value);
+};
+
+struct EPDOptions {
+    unsigned threads = 0; // 0: one per core
+    size_t windowBytes = 64 << 20; // address space mapped at once, a line must fit in it
+};
+
+/**
+ * Streams the file through the consumer, one batch per chunk, in file order. The batches are only
+ * valid during the call. Throws std::runtime_error if the file cannot be opened or mapped, or if a
+ * line does not fit in a window. An exception in a parsing thread (std::bad_alloc...) is rethrown here.
+ */
+void streamEPD(const std::string& path, const std::function<void(const EPDBatch&)>& consumer, const EPDOptions& options = EPDOptions());
+
+/**
+ * Whole file in one batch, for files that fit in memory
+ */
+EPDBatch loadEPD(const std::string& path, const EPDOptions& options = EPDOptions());
+
+
+#endif
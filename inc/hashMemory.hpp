@@ -0,0 +1,80 @@
+#ifndef HASHMEMORY_HPP
+#define HASHMEMORY_HPP
+
+/**
+ * Memory for the big hash tables (transposition table, perft table).
+ *
+ * With gigabytes of table, every probe lands on a different 4 KB page and misses the TLB as well as the
+ * cache. Huge pages (2 MB) make the TLB cover the whole table, so the block is taken from, in this order:
+ *  - explicit huge pages (MAP_HUGETLB), if the system has some reserved
+ *  - transparent huge pages: 2 MB aligned memory, with madvise(MADV_HUGEPAGE)
+ *  - ordinary pages, cache line aligned
+ * The content is not initialized: clear it with clearHashMemory.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+
+class HashMemory {
+    private:
+        void* memory = nullptr;
+        size_t bytes = 0; // as allocated, maybe rounded up
+        bool mapped = false; // from mmap, else from aligned_alloc
+        bool hugePages = false;
+
+        void release();
+
+    public:
+        HashMemory() = default;
+
+        /**
+         * @throws std::bad_alloc if there is not enough memory
+         */
+        explicit HashMemory(size_t bytes);
+        ~HashMemory() {release();}
+
+        HashMemory(const HashMemory&) = delete;
+        HashMemory& operator=(const HashMemory&) = delete;
+        HashMemory(HashMemory&& other) noexcept;
+        HashMemory& operator=(HashMemory&& other) noexcept;
+
+        void* get() const {return memory;}
+        size_t size() const {return bytes;}
+
+        /**
+         * Explicit huge pages, or transparent ones accepted by madvise (the kernel may still split them)
+         */
+        bool usesHugePages() const {return hugePages;}
+};
+
+/**
+ * Bucket of the key in a table of bucketCount buckets: the high bits of the key, through a multiply-high,
+ * so that any count works and the low bits are left for the entry checks.
+ */
+inline size_t getBucketIndex(uint64_t key, size_t bucketCount) {
+    return static_cast<size_t>((static_cast<unsigned __int128>(key) * bucketCount) >> 64);
+}
+
+/**
+ * Where the bucket of a key lives in a table, so that code which does not know the table (Position::play)
+ * can prefetch it. The default target is no table: prefetch does nothing.
+ */
+struct PrefetchTarget {
+    const char* base = nullptr;
+    size_t bucketCount = 0;
+    size_t bucketSize = 0;
+
+    void prefetch(uint64_t key) const {
+        if (base) __builtin_prefetch(base + getBucketIndex(key, bucketCount) * bucketSize);
+    }
+};
+
+/**
+ * Zeroes the block, each thread a slice. The pages are first touched by the threads, which also spreads
+ * the page faults of a fresh allocation.
+ */
+void clearHashMemory(void* memory, size_t bytes, unsigned threads);
+
+
+#endif
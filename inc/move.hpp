@@ -9,6 +9,7 @@
 
 #include <cstdint>
 #include <cstdlib> // for abs
+#include <cctype> // for std::tolower / std::toupper
 #include <stdexcept> // for std::runtime_error
 #include <string>
 #include <memory> // for std::unique_ptr
@@ -61,9 +62,16 @@ inline constexpr Color getColor(Piece piece) {
 }
 
 inline constexpr Figure getFigure(Piece piece) {
-    return static_cast<Figure>(piece & 0x0111); // 0x7 is the bits for figure
+    return static_cast<Figure>(piece & 0b0111); // 0x7 is the bits for figure
 } // 0x7 = 0b0111 --> mask all except the last 3 bits
 
+/**
+ * WHITE = 0, BLACK = 8 --> index 0 or 1, to index per-color tables
+ */
+inline constexpr uint32_t getColorIndex(Color color) {
+    return static_cast<uint32_t>(color) >> 3; // divide by 8
+}
+
 inline constexpr char getCharFromPiece(Piece piece) {
     // returns the character representation of the piece, in lowercase for black pieces
     char c = ' ';
@@ -126,15 +134,45 @@ class Move {
         // Next bits: piece being moved (4 bits)
         // Next bits: captured piece (4 bits)
         // Next bits: promotion piece (4 bits)
+        // Last bits: flags for the special moves (4 bits), see below
         uint32_t move;
         // UndoInfo undoInfo; // information about the previous position, useful for the unplay method!
         // actually, UndoInfo is common to all moves for a given position, so let's rather attach it to
         // the positition and not the move itself.
 
+        /**
+         * Left uninitialized like an int, so that a MoveList does not fill its 256 entries at every node.
+         * Move() and Move{} (value initialization) give the null move: a1a1 with no piece, never generated.
+         */
+        Move() = default;
         Move(uint32_t move) : move(move) {}
 
-        Move(Square from, Square to, Piece piece, Piece captured = makePiece(Color::WHITE, Figure::EMPTY), Piece promotion = makePiece(Color::WHITE,Figure::EMPTY)) {
-            move = from << 18 | to << 12 | piece << 8 | captured << 4 | promotion; // << means move up!
+        /**
+         * Special moves are flagged once, when the move is created, so that isCastle & co are a single mask
+         * test in play / unplay / updateHash. The generator knows which kind of move it makes and passes the
+         * flag itself; the other constructor works it out from the pieces and squares.
+         */
+        static constexpr uint32_t CASTLE_FLAG = 1 << 24;
+        static constexpr uint32_t EN_PASSANT_FLAG = 1 << 25;
+        static constexpr uint32_t DOUBLE_PUSH_FLAG = 1 << 26;
+        static constexpr uint32_t PROMOTION_FLAG = 1 << 27;
+
+        Move(Square from, Square to, Piece piece, Piece captured, Piece promotion, uint32_t flags) {
+            move = from << 18 | to << 12 | piece << 8 | captured << 4 | promotion | flags; // << means move up!
+        }
+
+        Move(Square from, Square to, Piece piece, Piece captured = makePiece(Color::WHITE, Figure::EMPTY), Piece promotion = makePiece(Color::WHITE,Figure::EMPTY))
+            : Move(from, to, piece, captured, promotion, getFlags(from, to, piece, captured, promotion)) {}
+
+        static uint32_t getFlags(Square from, Square to, Piece piece, Piece captured, Piece promotion) {
+            const int rowDistance = std::abs(static_cast<int>(getRow(from)) - static_cast<int>(getRow(to)));
+            const int colDistance = std::abs(static_cast<int>(getCol(from)) - static_cast<int>(getCol(to)));
+            uint32_t flags = 0;
+            if (getFigure(piece) == Figure::KING && colDistance == 2) flags |= CASTLE_FLAG;
+            if (getFigure(piece) == Figure::PAWN && colDistance != 0 && getFigure(captured) == Figure::EMPTY) flags |= EN_PASSANT_FLAG;
+            if (getFigure(piece) == Figure::PAWN && rowDistance == 2) flags |= DOUBLE_PUSH_FLAG;
+            if (getFigure(promotion) != Figure::EMPTY) flags |= PROMOTION_FLAG;
+            return flags;
         }
 
         Square getFrom() const {
@@ -163,8 +201,15 @@ class Move {
             return move;
         }
 
+        bool isNull() const {
+            return move == 0;
+        }
+
+        bool operator==(const Move& other) const {return move == other.move;}
+        bool operator!=(const Move& other) const {return move != other.move;}
+
         bool isPromotion() const {
-            return getFigure(getPromotion()) != Figure::EMPTY;
+            return move & PROMOTION_FLAG;
         }
 
         /**
@@ -175,53 +220,144 @@ class Move {
         }
 
         /**
-         * If pawn moves diagonally but getCapture is empty
+         * Pawn moving diagonally to an empty square (getCapture is empty)
          */
         bool isEnPassant() const {
-            return getFigure(getPiece()) == Figure::PAWN && getCol(getFrom()) != getCol(getTo()) && !isCapture();
+            return move & EN_PASSANT_FLAG;
         }
 
         bool isCastle() const {
-            return getFigure(getPiece()) == Figure::KING && (abs(getCol(getFrom()) - getCol(getTo())) == 2);
+            return move & CASTLE_FLAG;
         }
 
         bool isDoubleAdvance() const {
-            return getFigure(getPiece()) == Figure::PAWN && abs(getRow(getFrom()) - getRow(getTo())) == 2;
+            return move & DOUBLE_PUSH_FLAG;
         }
 
+        /**
+         * Square skipped by a double advance, i.e. the new en passant target
+         */
         uint32_t getEnPassantSquare() const {
+            if (!isDoubleAdvance()) {
+                throw std::runtime_error("Move is not a double advance");
+            }
+            return (getFrom() + getTo()) / 2;
+        }
+
+        /**
+         * Square of the pawn taken en passant: row of origin, column of destination
+         */
+        uint32_t getEnPassantCaptureSquare() const {
             if (!isEnPassant()) {
                 throw std::runtime_error("Move is not an en passant move");
             }
-            return (getFrom() + getTo()) / 2;
+            return getRow(getFrom()) * 8 + getCol(getTo());
         }
 
-        std::string toString() {
-            // Returns move in UCI format, e.g., "e2e4", "e7e8q"
-            auto squareToStr = [](Square sq) -> std::string {
-                char file = 'a' + getCol(sq);
-                char rank = '1' + getRow(sq);
-                return std::string{file, rank};
-            };
+        /**
+         * Longest UCI move ("e7e8q") with its terminating '\0'
+         */
+        static constexpr size_t UCI_LENGTH = 6;
 
-            std::string str = squareToStr(getFrom()) + squareToStr(getTo());
+        /**
+         * Writes the move in UCI format, e.g. "e2e4", "e7e8q", into buffer (at least UCI_LENGTH chars,
+         * '\0' terminated). Returns the length of the move, 4 or 5. Nothing is allocated.
+         */
+        size_t toUCI(char* buffer) const {
+            const Square from = getFrom();
+            const Square to = getTo();
+            buffer[0] = static_cast<char>('a' + getCol(from));
+            buffer[1] = static_cast<char>('1' + getRow(from));
+            buffer[2] = static_cast<char>('a' + getCol(to));
+            buffer[3] = static_cast<char>('1' + getRow(to));
+            size_t length = 4;
             if (isPromotion()) {
-                Figure promo = getFigure(getPromotion());
-                char promoChar = 'q'; // default
-                switch (promo) {
-                    case Figure::KNIGHT: promoChar = 'n'; break;
-                    case Figure::BISHOP: promoChar = 'b'; break;
-                    case Figure::ROOK:   promoChar = 'r'; break;
-                    case Figure::QUEEN:  promoChar = 'q'; break;
-                    default: break;
-                }
-                str += promoChar;
+                buffer[length++] = "  nbrq "[static_cast<uint32_t>(getFigure(getPromotion()))];
             }
-            return str;
+            buffer[length] = '\0';
+            return length;
+        }
+
+        /**
+         * Move in UCI format, e.g. "e2e4", "e7e8q". Use toUCI in loops, this one builds a string.
+         */
+        std::string toString() const {
+            char buffer[UCI_LENGTH];
+            return std::string(buffer, toUCI(buffer));
         }
 
         
 };
 
+
+
+
+// ------------------- //
+// !-- Packed Move --! //
+// ------------------- //
+
+/**
+ * The same move in 16 bits, for storage (transposition table, killers, history, game archives):
+ * from (6 bits) | to (6 bits) << 6 | promotion figure - KNIGHT (2 bits) << 12 | type (2 bits) << 14.
+ * The moved and captured pieces are not stored, they are read back from the position with unpack.
+ * A packed move coming from a table may not belong to the position: check the unpacked move with isLegal.
+ */
+class PackedMove {
+    public:
+        enum Type : uint16_t {
+            NORMAL = 0,
+            PROMOTION = 1,
+            EN_PASSANT = 2,
+            CASTLE = 3,
+        };
+
+        uint16_t move;
+
+        PackedMove() = default; // same as Move: PackedMove() is the null move, a1a1
+        explicit PackedMove(uint16_t move) : move(move) {}
+
+        PackedMove(const Move& full) {
+            uint16_t type = NORMAL, promotion = 0;
+            if (full.isPromotion()) {
+                type = PROMOTION;
+                promotion = static_cast<uint16_t>(getFigure(full.getPromotion())) - static_cast<uint16_t>(Figure::KNIGHT);
+            } else if (full.isEnPassant()) {
+                type = EN_PASSANT;
+            } else if (full.isCastle()) {
+                type = CASTLE;
+            }
+            move = static_cast<uint16_t>(full.getFrom() | full.getTo() << 6 | promotion << 12 | type << 14);
+        }
+
+        Square getFrom() const {return move & 0b111111;}
+        Square getTo() const {return (move >> 6) & 0b111111;}
+        Type getType() const {return static_cast<Type>(move >> 14);}
+        bool isNull() const {return move == 0;}
+
+        /**
+         * Promotion figure, only meaningful for PROMOTION moves
+         */
+        Figure getPromotionFigure() const {
+            return static_cast<Figure>(((move >> 12) & 0b11) + static_cast<uint32_t>(Figure::KNIGHT));
+        }
+
+        bool operator==(const PackedMove& other) const {return move == other.move;}
+        bool operator!=(const PackedMove& other) const {return move != other.move;}
+
+        /**
+         * Full move in this position (any class with getPieceAt): the pieces are read from the board.
+         */
+        template<typename P>
+        Move unpack(const P& position) const {
+            if (isNull()) return Move();
+            const Square from = getFrom();
+            const Square to = getTo();
+            const Piece piece = position.getPieceAt(from);
+            const Piece captured = getType() == EN_PASSANT ? makePiece(Color::WHITE, Figure::EMPTY) : position.getPieceAt(to);
+            const Piece promotion = getType() == PROMOTION ? makePiece(getColor(piece), getPromotionFigure()) : makePiece(Color::WHITE, Figure::EMPTY);
+            return Move(from, to, piece, captured, promotion);
+        }
+};
+
 #endif
 
@@ -0,0 +1,74 @@
+#ifndef MOVELIST_HPP
+#define MOVELIST_HPP
+
+/**
+ * Fixed capacity list of moves, living on the stack of the node that generates them.
+ *
+ * A std::vector allocates (and frees) at every node of the search, which costs more than generating the
+ * moves. No position has more than 218 legal moves, so 256 entries are always enough and nothing ever
+ * touches the heap. The entries are not initialized: only the first size() ones mean anything.
+ * Each move has a score next to it (parallel arrays, so that iterating over the moves stays compact),
+ * used by the move picker for ordering.
+ * The names follow std::vector, so that range-for and the generator's emplace_back work unchanged.
+ */
+
+#include "move.hpp"
+#include <cassert>
+#include <cstddef>
+#include <utility> // for std::swap
+
+
+class MoveList {
+    public:
+        static constexpr size_t CAPACITY = 256;
+
+    private:
+        Move moves[CAPACITY];
+        int32_t scores[CAPACITY];
+        size_t count = 0;
+
+    public:
+        template<typename... Args>
+        void emplace_back(Args... args) {
+            assert(count < CAPACITY);
+            moves[count++] = Move(args...);
+        }
+
+        void push_back(const Move& move) {
+            assert(count < CAPACITY);
+            moves[count++] = move;
+        }
+
+        void pop_back() {count--;}
+        void clear() {count = 0;}
+        size_t size() const {return count;}
+        bool empty() const {return count == 0;}
+
+        Move& operator[](size_t i) {return moves[i];}
+        const Move& operator[](size_t i) const {return moves[i];}
+        Move& front() {return moves[0];}
+        const Move& front() const {return moves[0];}
+        Move& back() {return moves[count - 1];}
+        const Move& back() const {return moves[count - 1];}
+
+        Move* begin() {return moves;}
+        Move* end() {return moves + count;}
+        const Move* begin() const {return moves;}
+        const Move* end() const {return moves + count;}
+
+        // !-- Scores --! //
+
+        int32_t getScore(size_t i) const {return scores[i];}
+        void setScore(size_t i, int32_t score) {scores[i] = score;}
+
+        /**
+         * Swaps two entries, moves and scores together
+         */
+        void swap(size_t i, size_t j) {
+            std::swap(moves[i], moves[j]);
+            std::swap(scores[i], scores[j]);
+        }
+};
+
+
+#endif
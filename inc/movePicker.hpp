@@ -0,0 +1,73 @@
+#ifndef MOVEPICKER_HPP
+#define MOVEPICKER_HPP
+
+/**
+ * Move ordering for the search, generated lazily.
+ *
+ * In alpha-beta most cutoffs happen on the transposition table move or on the first good capture, so
+ * generating and scoring the quiet moves before trying those is wasted work. The picker hands out the moves
+ * in stages, and only generates a stage when the previous one is exhausted:
+ *  1. the TT move, checked with isLegal (nothing generated yet)
+ *  2. captures and promotions that do not lose material (seeGE), best MVV-LVA first (most valuable victim,
+ *     least valuable attacker)
+ *  3. the killer moves, if they are legal quiet moves here
+ *  4. the quiet moves, best history score first
+ *  5. the losing captures, kept aside during stage 2
+ * Each move is handed out once: the TT move and the killers are skipped when they come out of the generator.
+ */
+
+#include "movegen.hpp"
+#include "see.hpp"
+
+/**
+ * History of the quiet moves that produced cutoffs, indexed by [color index][from][to]. Owned by the search.
+ */
+using ButterflyHistory = int32_t[2][64][64];
+
+enum class PickerStage : uint32_t {
+    TT_MOVE,
+    GENERATE_CAPTURES,
+    GOOD_CAPTURES,
+    KILLERS,
+    GENERATE_QUIETS,
+    QUIETS,
+    BAD_CAPTURES,
+    END,
+};
+
+class MovePicker {
+    private:
+        const Position& position; // must not change while the picker is used (play / unplay around next is fine)
+        Move ttMove;
+        Move killers[2];
+        const ButterflyHistory* history; // may be null: quiets come in generation order
+
+        PickerStage stage;
+        MoveList moves; // moves of the current stage, the ones before 'current' were handed out
+        size_t current = 0;
+        MoveList badCaptures;
+        size_t currentBad = 0;
+        size_t currentKiller = 0;
+
+        void scoreCaptures();
+        void scoreQuiets();
+
+        /**
+         * Swaps the best remaining move to 'current' and returns it. Selection instead of a full sort:
+         * after a cutoff, the rest of the list is never looked at.
+         */
+        Move pickBest();
+
+    public:
+        MovePicker(const Position& position, Move ttMove = Move(), Move killer1 = Move(), Move killer2 = Move(), const ButterflyHistory* history = nullptr);
+
+        /**
+         * Next move to try, or a null Move once every legal move was handed out.
+         */
+        Move next();
+
+        PickerStage getStage() const {return stage;}
+};
+
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef MOVEGEN_HPP
+#define MOVEGEN_HPP
+
+/**
+ * Legal move generation.
+ *
+ * Instead of generating pseudo legal moves and playing each of them to check king safety, everything the
+ * king cares about is computed once per position:
+ *  - checkers: enemy pieces giving check. Two of them --> only king moves. One --> the other pieces must
+ *    capture it or block it (the evasion mask).
+ *  - pinned pieces: they can only move along the line joining them to their king.
+ *  - king moves are tested against the enemy attacks with the king removed from the board, so that it
+ *    cannot step back along the line of a slider.
+ * En passant is the only move removing two pieces from a line at once (it can discover a check along the
+ * row), so it is validated by looking at the sliders with the resulting occupancy.
+ * The generator is a template on the side to move (Us): pawn direction, promotion row and castling squares
+ * are constants, and the color branch is taken once per position instead of in the inner loops.
+ */
+
+#include "position.hpp"
+#include "moveList.hpp"
+#include <string_view>
+
+
+/**
+ * Which legal moves to generate. CAPTURES and QUIETS split ALL in two, so that a search can generate
+ * the quiet moves only when the captures did not produce a cutoff.
+ */
+enum class GenType : uint32_t {
+    CAPTURES, // captures (en passant included) and promotions
+    QUIETS, // everything else, castling included
+    ALL,
+};
+
+/**
+ * Appends the legal moves of the position. Captured pieces and promotions are filled in the moves,
+ * en passant captures have an empty capture field (see Move::isEnPassant).
+ * Every slider lookup inside uses the backend given here (see attacks.hpp).
+ */
+template<Color Us, GenType Type, SliderBackend Backend>
+void generateLegalMoves(const Position& position, MoveList& moves);
+
+/**
+ * Same, reading the slider backend once
+ */
+template<Color Us, GenType Type = GenType::ALL>
+inline void generateLegalMoves(const Position& position, MoveList& moves) {
+    if (usesPextSliders()) generateLegalMoves<Us, Type, SliderBackend::PEXT>(position, moves);
+    else generateLegalMoves<Us, Type, SliderBackend::MAGIC>(position, moves);
+}
+
+/**
+ * Same, dispatching on the side to move once: everything below is specialized by color
+ */
+template<GenType Type = GenType::ALL>
+inline void generateLegalMoves(const Position& position, MoveList& moves) {
+    if (position.getActiveColor() == Color::WHITE) generateLegalMoves<Color::WHITE, Type>(position, moves);
+    else generateLegalMoves<Color::BLACK, Type>(position, moves);
+}
+
+/**
+ * Is the move legal in this position, without generating anything. Meant for moves coming from elsewhere
+ * (transposition table, killers), which may belong to another position: every field of the move is checked.
+ */
+bool isLegal(const Position& position, const Move& move);
+
+/**
+ * Reads a move in UCI format ("e2e4", "e7e8q", castling as the king move "e1g1") in this position: the moved
+ * and captured pieces come from the board. Returns a null Move if the text is not a move or the move is not
+ * legal here. Nothing is allocated, so it can be called on every token of a game or engine output.
+ */
+Move parseUCIMove(const Position& position, std::string_view text);
+
+/**
+ * Same for standard algebraic notation ("Nf3", "exd5", "R1e2", "e8=Q", "O-O-O", check marks and
+ * annotations allowed), as found in EPD and PGN files. The legal moves are generated and the one
+ * matching the text is returned, a null Move if there is none or the text is ambiguous.
+ */
+Move parseSANMove(const Position& position, std::string_view text);
+
+#endif
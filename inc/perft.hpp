@@ -0,0 +1,127 @@
+#ifndef PERFT_HPP
+#define PERFT_HPP
+
+/**
+ * Perft: counts the leaves of the legal move tree to a given depth. The counts of the standard positions
+ * are well known, so any bug in generation or in play / unplay shows up as a wrong number, and the time it
+ * takes is our benchmark for move generation speed.
+ *
+ * Bulk counting: at depth 1, the number of legal moves is the number of leaves, no need to play them.
+ * This is what engines usually report; without it, the leaves are played and unplayed too (slower, but it
+ * also measures play / unplay).
+ *
+ * The parallel versions split the tree a few plies below the root, until there are enough subtrees to keep
+ * every thread busy, and hand the subtrees out one at a time: each thread works on its own copy of the
+ * position, and the only shared state is the index of the next subtree.
+ *
+ * Optionally, the node counts of the subtrees are cached in a PerftTable keyed by zobrist key and depth:
+ * at high depth the same positions are reached through many move orders (transpositions).
+ */
+
+#include "movegen.hpp"
+#include "hashMemory.hpp"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+
+struct PerftPosition {
+    std::string name;
+    std::string fen;
+    std::vector<uint64_t> nodes; // nodes[d - 1] is perft(d)
+};
+
+/**
+ * Startpos, Kiwipete and the other positions of the chessprogramming wiki, plus a few special cases.
+ */
+extern const std::vector<PerftPosition> PERFT_SUITE;
+
+// ------------------- //
+// !-- Perft Table --! //
+// ------------------- //
+
+/**
+ * Subtree counts by (zobrist key, depth), sized by a memory budget. One entry per slot, always replaced.
+ *
+ * Lock-free, so that all the threads of a parallel perft share it: an entry is two 64 bits words written
+ * without any lock, and a thread may read the words of two different writes. The first word is stored as
+ * key ^ data, so such a torn entry does not give back the key it is probed with, and is simply a miss.
+ */
+class PerftTable {
+    private:
+        struct Entry {
+            std::atomic<uint64_t> check; // key ^ data
+            std::atomic<uint64_t> data; // nodes << 8 | depth
+        };
+
+        std::unique_ptr<Entry[]> entries;
+        size_t count; // a power of 2
+
+    public:
+        /**
+         * Largest power of 2 number of entries fitting in the budget (at least one entry)
+         */
+        PerftTable(size_t megabytes);
+
+        void clear();
+        size_t getEntryCount() const {return count;}
+
+        /**
+         * For Position::setPrefetchTarget: one entry per bucket
+         */
+        PrefetchTarget getPrefetchTarget() const {
+            return {reinterpret_cast<const char*>(entries.get()), count, sizeof(Entry)};
+        }
+
+        bool probe(uint64_t key, int depth, uint64_t& nodes) const {
+            const Entry& entry = entries[getBucketIndex(key, count)];
+            const uint64_t data = entry.data.load(std::memory_order_relaxed);
+            if ((entry.check.load(std::memory_order_relaxed) ^ data) != key || (data & 0xFF) != static_cast<uint64_t>(depth)) {
+                return false;
+            }
+            nodes = data >> 8;
+            return true;
+        }
+
+        void store(uint64_t key, int depth, uint64_t nodes) {
+            Entry& entry = entries[getBucketIndex(key, count)];
+            const uint64_t data = nodes << 8 | static_cast<uint64_t>(depth);
+            entry.check.store(key ^ data, std::memory_order_relaxed);
+            entry.data.store(data, std::memory_order_relaxed);
+        }
+};
+
+
+
+// ------------- //
+// !-- Perft --! //
+// ------------- //
+
+template<Color Us, bool Bulk, SliderBackend Backend>
+uint64_t perft(Position& position, int depth, PerftTable* table = nullptr);
+
+/**
+ * Leaves of the tree at the given depth (depth 0 --> 1, the position itself)
+ */
+uint64_t perft(Position& position, int depth, bool bulk = true, PerftTable* table = nullptr);
+
+struct DivideEntry {
+    Move move;
+    uint64_t nodes;
+};
+
+/**
+ * Perft of each root move at depth - 1, in generation order. The sum is perft(depth).
+ * Compare with another engine's divide to find the move that goes wrong.
+ */
+std::vector<DivideEntry> divide(Position& position, int depth, bool bulk = true, PerftTable* table = nullptr);
+
+/**
+ * Same as divide / perft, spread over the given number of threads (1 --> the serial versions).
+ */
+std::vector<DivideEntry> parallelDivide(const Position& position, int depth, unsigned threads, bool bulk = true, PerftTable* table = nullptr);
+uint64_t parallelPerft(const Position& position, int depth, unsigned threads, bool bulk = true, PerftTable* table = nullptr);
+
+
+#endif
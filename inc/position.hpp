@@ -0,0 +1,274 @@
+#ifndef POSITION_HPP
+#define POSITION_HPP
+
+#include "positionBase.hpp"
+#include "bitboard.hpp"
+#include "attacks.hpp"
+#include "hashMemory.hpp"
+#include <string>
+#include <string_view>
+
+
+/**
+ * What is wrong with a FEN, see Position::parseFEN
+ */
+enum class FENError : uint32_t {
+    NONE,
+    FIELDS, // less than 4 fields
+    BOARD, // bad piece character, or not 8 rows of 8 squares
+    KINGS, // not exactly one king per side
+    ACTIVE_COLOR,
+    CASTLING,
+    EN_PASSANT, // not on the row behind a pawn that just moved two squares
+    OPPONENT_IN_CHECK, // the side not to move is in check: its king could be captured
+    CLOCKS, // halfmove or fullmove clock is not a number
+};
+
+const char* getFENErrorMessage(FENError error);
+
+/**
+ * A position in 32 bytes, for large position sets (see epd.hpp): the occupancy, then 4 bits per piece
+ * in square order. Up to 32 pieces, which covers every legal position. The histories are not kept.
+ */
+struct PackedPosition {
+    Bitboard occupied;
+    uint8_t pieces[16]; // two pieces per byte, the lower square in the low bits
+    uint8_t activeColor;
+    uint8_t castlingRights;
+    uint8_t enPassantSquare;
+    uint8_t halfmoveClock; // capped at 255
+    uint16_t fullmoveClock; // capped at 65535
+};
+
+
+/**
+ * Concrete position, stored twice:
+ *  - one bitboard per piece and one per color, for move generation
+ *  - an 8x8 mailbox, so that getPieceAt is a single array read
+ *
+ * play / unplay keep both representations, the zobrist key and the histories up to date in place.
+ */
+class Position : public PositionBase<Position> {
+    protected:
+        Bitboard pieceBB[16] = {}; // indexed by Piece (color | figure), EMPTY entries stay at 0
+        Bitboard colorBB[2] = {}; // indexed by getColorIndex
+        Piece mailbox[64] = {}; // 8x8 board flattened, same indices as Square
+        uint8_t pieceCount[16] = {}; // indexed by Piece, for the material key
+        PrefetchTarget prefetchTarget; // table probed with the new key after play, see setPrefetchTarget
+
+        void putPiece(Piece piece, Square square);
+        void removePiece(Square square);
+        void movePiece(Square from, Square to);
+
+        void clear();
+
+    public:
+        static constexpr size_t HISTORY_CAPACITY = 1024; // plies reserved in the histories
+        static inline const std::string startpos = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+        static constexpr size_t FEN_LENGTH = 104; // longest FEN writeFEN can produce, '\0' included
+
+        Position();
+        Position(std::string_view fen);
+
+        /**
+         * Parses the FEN into this position, without exceptions nor allocation (the histories keep their
+         * capacity): meant for loading positions in bulk, reusing one Position. The clocks are optional
+         * and fields after them are ignored. If an error is returned, the position is garbage until the
+         * next successful parse.
+         */
+        FENError parseFEN(std::string_view fen);
+
+        /**
+         * @brief Parse and store position from FEN string.
+         * @throws std::invalid_argument if the FEN string is invalid.
+         */
+        void fromFEN(std::string_view fen);
+
+        /**
+         * Writes the FEN into buffer (at least FEN_LENGTH chars, '\0' terminated) and returns its length.
+         */
+        size_t writeFEN(char* buffer) const;
+        std::string toFEN() const;
+
+        /**
+         * The position must have at most 32 pieces (see PackedPosition).
+         */
+        PackedPosition pack() const;
+        void unpack(const PackedPosition& packed);
+
+        // ----------------- //
+        // !-- Accessors --! //
+        // ----------------- //
+
+        Piece getPieceAt(Square square) const {
+            return mailbox[square];
+        }
+
+        uint32_t getPieceCount(Piece piece) const {
+            return pieceCount[piece];
+        }
+
+        Bitboard getPieces(Piece piece) const {
+            return pieceBB[piece];
+        }
+
+        Bitboard getPieces(Color color, Figure figure) const {
+            return pieceBB[makePiece(color, figure)];
+        }
+
+        Bitboard getPieces(Color color) const {
+            return colorBB[getColorIndex(color)];
+        }
+
+        Bitboard getOccupied() const {
+            return colorBB[0] | colorBB[1];
+        }
+
+        Square getKingSquare(Color color) const {
+            return lsb(pieceBB[makePiece(color, Figure::KING)]);
+        }
+
+        Color getActiveColor() const {return activeColor;}
+        uint32_t getCastlingRights() const {return castlingRights;}
+        Square getEnPassantSquare() const {return enPassantSquare;}
+        uint32_t getHalfmoveClock() const {return halfmoveClock;}
+        uint32_t getFullmoveClock() const {return fullmoveClock;}
+
+        using PositionBase::getZobristKey;
+        using PositionBase::getPawnKey;
+        using PositionBase::getNonPawnKey;
+        using PositionBase::getMaterialKey;
+
+        // --------------- //
+        // !-- Attacks --! //
+        // --------------- //
+
+        /**
+         * Pieces of both colors attacking the square, given the occupancy (which may differ from the board,
+         * for instance to look through a piece about to move). With the slider backend known at compile
+         * time for the hot code, without for the rest (see attacks.hpp).
+         */
+        template<SliderBackend Backend>
+        Bitboard getAttackersTo(Square square, Bitboard occupied) const {
+            return (pawnAttacks(Color::BLACK, square) & pieceBB[makePiece(Color::WHITE, Figure::PAWN)])
+                 | (pawnAttacks(Color::WHITE, square) & pieceBB[makePiece(Color::BLACK, Figure::PAWN)])
+                 | (knightAttacks(square) & (pieceBB[makePiece(Color::WHITE, Figure::KNIGHT)] | pieceBB[makePiece(Color::BLACK, Figure::KNIGHT)]))
+                 | (kingAttacks(square) & (pieceBB[makePiece(Color::WHITE, Figure::KING)] | pieceBB[makePiece(Color::BLACK, Figure::KING)]))
+                 | (bishopAttacks<Backend>(square, occupied) & getDiagonalSliders())
+                 | (rookAttacks<Backend>(square, occupied) & getOrthogonalSliders());
+        }
+
+        Bitboard getAttackersTo(Square square, Bitboard occupied) const {
+            return usesPextSliders() ? getAttackersTo<SliderBackend::PEXT>(square, occupied) : getAttackersTo<SliderBackend::MAGIC>(square, occupied);
+        }
+
+        bool isInCheck() const {
+            return isAttacked(getKingSquare(activeColor), ~activeColor);
+        }
+
+        /**
+         * Pieces of color By attacking the square, given the occupancy
+         */
+        template<Color By, SliderBackend Backend>
+        Bitboard getAttackersBy(Square square, Bitboard occupied) const {
+            return (pawnAttacks(~By, square) & pieceBB[makePiece(By, Figure::PAWN)])
+                 | (knightAttacks(square) & pieceBB[makePiece(By, Figure::KNIGHT)])
+                 | (kingAttacks(square) & pieceBB[makePiece(By, Figure::KING)])
+                 | (bishopAttacks<Backend>(square, occupied) & (pieceBB[makePiece(By, Figure::BISHOP)] | pieceBB[makePiece(By, Figure::QUEEN)]))
+                 | (rookAttacks<Backend>(square, occupied) & (pieceBB[makePiece(By, Figure::ROOK)] | pieceBB[makePiece(By, Figure::QUEEN)]));
+        }
+
+        template<Color By>
+        Bitboard getAttackersBy(Square square, Bitboard occupied) const {
+            return usesPextSliders() ? getAttackersBy<By, SliderBackend::PEXT>(square, occupied) : getAttackersBy<By, SliderBackend::MAGIC>(square, occupied);
+        }
+
+        /**
+         * Is the square attacked by a piece of the given color
+         */
+        bool isAttacked(Square square, Color by) const {
+            return by == Color::WHITE ? isAttacked<Color::WHITE>(square) : isAttacked<Color::BLACK>(square);
+        }
+
+        template<Color By>
+        bool isAttacked(Square square) const {
+            return getAttackersBy<By>(square, getOccupied());
+        }
+
+        Bitboard getDiagonalSliders() const {
+            return pieceBB[makePiece(Color::WHITE, Figure::BISHOP)] | pieceBB[makePiece(Color::WHITE, Figure::QUEEN)]
+                 | pieceBB[makePiece(Color::BLACK, Figure::BISHOP)] | pieceBB[makePiece(Color::BLACK, Figure::QUEEN)];
+        }
+
+        Bitboard getOrthogonalSliders() const {
+            return pieceBB[makePiece(Color::WHITE, Figure::ROOK)] | pieceBB[makePiece(Color::WHITE, Figure::QUEEN)]
+                 | pieceBB[makePiece(Color::BLACK, Figure::ROOK)] | pieceBB[makePiece(Color::BLACK, Figure::QUEEN)];
+        }
+
+        // ------------------- //
+        // !-- Repetitions --! //
+        // ------------------- //
+
+        /**
+         * Has the current position already occurred? Only the last halfmoveClock plies can hold it (a capture
+         * or a pawn move cannot be undone), and only every other one (same side to move), so the scan is
+         * short whatever the length of the game.
+         */
+        bool isRepetition() const;
+
+        /**
+         * Third occurrence of the position: the game is drawn
+         */
+        bool isThreefoldRepetition() const;
+
+        /**
+         * Can the side to move get back to an earlier position with a single reversible move? If so, the
+         * search can score the node as a draw one move early. ply is the distance to the search root: before
+         * the root, the earlier position must itself be a repetition to count (the game is not drawn yet).
+         * Uses the cuckoo tables of cuckoo.hpp.
+         */
+        bool hasUpcomingRepetition(int ply) const;
+
+        // --------------------- //
+        // !-- Play & Unplay --! //
+        // --------------------- //
+
+        /**
+         * play prefetches the bucket of the new key in this table (transposition table, perft table) as soon
+         * as the key is known: the cache miss is paid while the pieces move, not when the child node probes.
+         * Set it once per search (or per UCI position), it is kept by copies of the position.
+         */
+        void setPrefetchTarget(const PrefetchTarget& target) {prefetchTarget = target;}
+        const PrefetchTarget& getPrefetchTarget() const {return prefetchTarget;}
+
+        /**
+         * Applies the move, which must be legal in this position.
+         */
+        void play(const Move& move) {
+            if (activeColor == Color::WHITE) play<Color::WHITE>(move);
+            else play<Color::BLACK>(move);
+        }
+
+        /**
+         * Takes back the move, which must be the last one played.
+         */
+        void unplay(const Move& move) {
+            if (activeColor == Color::WHITE) unplay<Color::BLACK>(move); // the last move was black's
+            else unplay<Color::WHITE>(move);
+        }
+
+        /**
+         * Same as play / unplay when the color of the move (Us) is known at compile time, for instance
+         * in a search specialized by color: pawn direction, castling squares and color indices are constants.
+         * Prefetch = false skips the prefetch, for children that will not probe the table (last plies of perft).
+         */
+        template<Color Us, bool Prefetch = true>
+        void play(const Move& move);
+
+        template<Color Us>
+        void unplay(const Move& move);
+};
+
+
+#endif
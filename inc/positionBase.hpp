@@ -1,12 +1,83 @@
-
 #ifndef POSITIONBASE_HPP
 #define POSITIONBASE_HPP
 
+/**
+ * Everything a position needs besides its board representation: rights, clocks, histories, and the
+ * zobrist key updated in place by play / unplay.
+ *
+ * PositionBase is a CRTP base: Derived (the concrete position) passes itself as template argument, and
+ * the base reaches getPieceAt through a static_cast instead of a virtual call. Every call of play / unplay
+ * is then resolved at compile time and can be inlined. When something really needs to hold "any position"
+ * behind a pointer (tooling, UI), wrap it in a PositionAdapter, which implements the virtual
+ * PositionInterface on top of it; the search never goes through it.
+ */
+
 #include "move.hpp"
+#include <string>
 #include <vector>
 
 
 
+// ---------------------- //
+// !-- Zobrist Tables --! //
+// ---------------------- //
+
+/**
+ * One random key per (color, figure, square), castling rights, en passant column and side to move.
+ * Shared by every position whatever its representation, so they live outside of the template.
+ *
+ * The keys are generated at compile time from a fixed seed (splitmix64), so they are the same in every build
+ * and every process: hashes can be saved to disk (transposition table dumps, books) and compared between
+ * programs. Change the seed and every saved hash becomes garbage.
+ */
+inline constexpr uint64_t ZOBRIST_SEED = 0x5EED0F2A7C0B1E55ULL;
+
+struct Zobrist {
+    uint64_t pieceKeys[2 /*colors*/][6 /*figures*/][64 /*squares*/] = {};
+    uint64_t castlingKeys[16 /*castling rights*/] = {}; // 2^4bits
+    uint64_t enPassantKeys[8 /*columns*/] = {};
+    uint64_t activeColorKey = 0;
+
+    /**
+     * splitmix64: a tiny generator with good statistical quality, easy to evaluate at compile time
+     */
+    static constexpr uint64_t nextRandom(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr Zobrist generate(uint64_t seed) {
+        Zobrist zobrist;
+        uint64_t state = seed;
+        for (int color = 0; color < 2; ++color) {
+            for (int piece = 0; piece < 6; ++piece) {
+                for (int square = 0; square < 64; ++square) {
+                    zobrist.pieceKeys[color][piece][square] = nextRandom(state);
+                }
+            }
+        }
+        for (int i = 0; i < 16; ++i) {
+            zobrist.castlingKeys[i] = nextRandom(state);
+        }
+        for (int i = 0; i < 8; ++i) {
+            zobrist.enPassantKeys[i] = nextRandom(state);
+        }
+        zobrist.activeColorKey = nextRandom(state);
+        return zobrist;
+    }
+};
+
+inline constexpr Zobrist ZOBRIST = Zobrist::generate(ZOBRIST_SEED);
+
+
+
+// -------------------- //
+// !-- PositionBase --! //
+// -------------------- //
+
+template<typename Derived>
 class PositionBase {
     protected:
         // !-- Variables --! //
@@ -23,13 +94,37 @@ class PositionBase {
          * Here is everything I (don't) understand about this. Goal is to be able to compare two positions.
          * When well implemented, this key can be modified back an fourth, in place, by play / unplay methods.
          * Thi is faster than storing / copying the key.
-         * 
-         * This key will be used for transposition table and for repetition detection, with someting like a 
-         * dictionnary. A smart choice of dictionnary structure will b needed at some point, but we will get 
+         *
+         * This key will be used for transposition table and for repetition detection, with someting like a
+         * dictionnary. A smart choice of dictionnary structure will b needed at some point, but we will get
          * there later. For our position history, a linear search might be faster than a dictionnary look up.
          */
 
-        virtual Piece getPieceAt(Square square) const = 0;
+        /**
+         * Partial keys for evaluation caches, updated in the same pass as zobristKey:
+         *  - pawnKey: the pawns of both colors (pawn structure tables)
+         *  - nonPawnKey[color]: the other pieces of that color, king included (correction tables)
+         *  - materialKey: how many pieces of each kind, not where (endgame dispatch). The n-th piece of a kind
+         *    adds pieceKeys[color][figure][n - 1], the square keys being reused as counters.
+         * The piece part of zobristKey is pawnKey ^ nonPawnKey[0] ^ nonPawnKey[1].
+         */
+        uint64_t pawnKey = 0;
+        uint64_t nonPawnKey[2] = {}; // indexed by getColorIndex
+        uint64_t materialKey = 0;
+
+        /**
+         * Derived::getPieceAt, resolved at compile time
+         */
+        Piece pieceAt(Square square) const {
+            return static_cast<const Derived*>(this)->getPieceAt(square);
+        }
+
+        /**
+         * Derived::getPieceCount: how many pieces of this kind are on the board
+         */
+        uint32_t pieceCount(Piece piece) const {
+            return static_cast<const Derived*>(this)->getPieceCount(piece);
+        }
 
 
 
@@ -37,8 +132,8 @@ class PositionBase {
         // !-- Play & Unplay --! //
         // --------------------- //
 
-        virtual uint32_t getNewCastlingRights(const Move& move) const;
-        virtual Square getNewEnPassantSquare(const Move& move) const;
+        uint32_t getNewCastlingRights(const Move& move) const;
+        Square getNewEnPassantSquare(const Move& move) const;
 
         // ----------------------- //
         // !-- Zobrist Hashing --! //
@@ -48,18 +143,251 @@ class PositionBase {
             return zobristKey;
         }
 
-        virtual void initializeHash();
-        virtual void updateHash(const Move& move);
-        virtual void restoreHash(const Move& move) {updateHash(move);} // updateHash is an involution.
-        
-        // Zobriest tables
-        static uint64_t pieceKeys[2 /*colors*/][6 /*figures*/][64 /*squares*/];
-        static uint64_t castlingKeys[16 /*castling rights*/]; // 2^4bits
-        static uint64_t enPassantKeys[8 /*columns*/];
-        static uint64_t activeColorKey;
-        static inline bool hashInitialized = false; // to avoid re-initializing the hash tables multiple times
-        static void initializeHashTables();
+        uint64_t getPawnKey() const {return pawnKey;}
+        uint64_t getNonPawnKey(Color color) const {return nonPawnKey[getColorIndex(color)];}
+        uint64_t getMaterialKey() const {return materialKey;}
+
+        void initializeHash();
+        void updateHash(const Move& move); // dispatches on the color of the moved piece
+        void restoreHash(const Move& move) {updateHash(move);} // updateHash is an involution.
+
+        /**
+         * Same as updateHash, for a move of color Us known at compile time:
+         * the color indices and the castling rook squares become constants.
+         */
+        template<Color Us>
+        void updateHash(const Move& move);
+};
+
+
+
+// --------------------- //
+// !-- Play & Unplay --! //
+// --------------------- //
+
+template<typename Derived>
+uint32_t PositionBase<Derived>::getNewCastlingRights(const Move& move) const {
+    uint32_t newRights = castlingRights;
+
+    // if the king has moved
+    if (getFigure(move.getPiece()) == Figure::KING) {
+        if (getColor(move.getPiece()) == Color::WHITE) {
+            newRights &= 0b0011; // remove white castling rights
+        } else {
+            newRights &= 0b1100; // remove black castling rights
+        }
+    }
+
+    // if a piece has moved away from a1 or took something on a1
+    if (move.getFrom() == 0 || move.getTo() == 0) {
+        newRights &= 0b1011; // remove white queenside castling rights
+    }
+    if (move.getFrom() == 7 || move.getTo() == 7) {
+        newRights &= 0b0111; // remove white kingside castling rights
+    }
+    if (move.getFrom() == 56 || move.getTo() == 56) {
+        newRights &= 0b1110; // remove black queenside castling rights
+    }
+    if (move.getFrom() == 63 || move.getTo() == 63) {
+        newRights &= 0b1101; // remove black kingside castling rights
+    }
+
+    return newRights;
+}
+
+template<typename Derived>
+Square PositionBase<Derived>::getNewEnPassantSquare(const Move& move) const {
+    Square newSquare = 64; // reset en passant square
+    if (move.isDoubleAdvance()) {
+        newSquare = move.getEnPassantSquare();
+    }
+    return newSquare;
+}
+
+
+
+// ----------------------- //
+// !-- Zobrist Hashing --! //
+// ----------------------- //
+
+template<typename Derived>
+void PositionBase<Derived>::initializeHash() {
+    zobristKey = pawnKey = materialKey = 0;
+    nonPawnKey[0] = nonPawnKey[1] = 0;
+    uint32_t counts[2][6] = {};
+
+    // 1) Hash based on pieces on the board
+    for (Square square = 0; square < 64; ++square) {
+        Piece piece = pieceAt(square);
+        if (getFigure(piece) != Figure::EMPTY) {
+            // color: WHITE = 0, BLACK = 8 --> index 0 or 1
+            uint32_t colorIndex = static_cast<uint32_t>(getColor(piece)) >> 3; // divide by 8
+            uint32_t figureIndex = static_cast<uint32_t>(getFigure(piece)) - 1; // EMPTY is 0
+            const uint64_t key = ZOBRIST.pieceKeys[colorIndex][figureIndex][square];
+            if (getFigure(piece) == Figure::PAWN) pawnKey ^= key;
+            else nonPawnKey[colorIndex] ^= key;
+            materialKey ^= ZOBRIST.pieceKeys[colorIndex][figureIndex][counts[colorIndex][figureIndex]++];
+        }
+    }
+    zobristKey = pawnKey ^ nonPawnKey[0] ^ nonPawnKey[1];
+
+    // 2) Hash based on castling rights
+    zobristKey ^= ZOBRIST.castlingKeys[castlingRights]; // 0 <= castlingRights < 16 since 4 bit integer
+
+    // 3) Hash based on en passant square
+    if (enPassantSquare < 64) { // valid en passant square
+        uint32_t column = getCol(enPassantSquare);
+        zobristKey ^= ZOBRIST.enPassantKeys[column];
+    }
+
+    // 4) Hash based on active color
+    if (activeColor == Color::BLACK) {
+        zobristKey ^= ZOBRIST.activeColorKey;
+    }
+}
+
+/**
+ * /!\ Must be called before applying the move!!
+ * The side to move is only known at runtime here, so pick the right specialization once.
+ */
+template<typename Derived>
+void PositionBase<Derived>::updateHash(const Move& move) {
+    if (getColor(move.getPiece()) == Color::WHITE) {
+        updateHash<Color::WHITE>(move);
+    } else {
+        updateHash<Color::BLACK>(move);
+    }
+}
+
+/**
+ * /!\ Must be called before applying the move!! (or after taking it back: the piece counts used for
+ * the material key must be the ones of the position before the move)
+ */
+template<typename Derived>
+template<Color Us>
+void PositionBase<Derived>::updateHash(const Move& move) {
+    constexpr uint32_t us = getColorIndex(Us);
+    constexpr uint32_t them = getColorIndex(~Us);
+    constexpr uint32_t pawnIndex = static_cast<uint32_t>(Figure::PAWN) - 1;
+    constexpr uint32_t rookIndex = static_cast<uint32_t>(Figure::ROOK) - 1;
+    constexpr Square kingFrom = Us == Color::WHITE ? 4 : 60;
+    const auto& pieceKeys = ZOBRIST.pieceKeys;
+
+    // 1) Unpack Move Info
+    const Square from = move.getFrom();
+    const Square to = move.getTo();
+    const uint32_t figureIndex = static_cast<uint32_t>(getFigure(move.getPiece())) - 1;
+    const Piece captured = move.getCapture();
+    const Piece promotion = move.getPromotion();
+
+    // 2) Get new castling rights and en passant square
+    uint32_t newCastlingRights = getNewCastlingRights(move);
+    Square newEnPassantSquare = getNewEnPassantSquare(move);
+
+    // 3) Piece movement (the pieces are hashed into pawn / non pawn deltas first, zobristKey takes both)
+    uint64_t pawnDelta = 0;
+    uint64_t nonPawnDelta[2] = {0, 0};
+    const uint64_t moveKeys = pieceKeys[us][figureIndex][from] ^ pieceKeys[us][figureIndex][to];
+    if (figureIndex == pawnIndex) pawnDelta ^= moveKeys;
+    else nonPawnDelta[us] ^= moveKeys;
+
+    // 4) Captured piece
+    if (getFigure(captured) != Figure::EMPTY) {
+        const uint32_t capturedIndex = static_cast<uint32_t>(getFigure(captured)) - 1;
+        if (capturedIndex == pawnIndex) pawnDelta ^= pieceKeys[them][pawnIndex][to];
+        else nonPawnDelta[them] ^= pieceKeys[them][capturedIndex][to];
+        materialKey ^= pieceKeys[them][capturedIndex][pieceCount(captured) - 1];
+    }
+
+    // 5) Move is enPassant --> remove the pawn that was captured (it belongs to the opponent)
+    if (move.isEnPassant()) {
+        pawnDelta ^= pieceKeys[them][pawnIndex][move.getEnPassantCaptureSquare()];
+        materialKey ^= pieceKeys[them][pawnIndex][pieceCount(makePiece(~Us, Figure::PAWN)) - 1];
+    }
+
+    // 6) Promotion --> pawn becomes new piece
+    if (move.isPromotion()) {
+        const uint32_t promotionIndex = static_cast<uint32_t>(getFigure(promotion)) - 1;
+        pawnDelta ^= pieceKeys[us][pawnIndex][to];
+        nonPawnDelta[us] ^= pieceKeys[us][promotionIndex][to];
+        materialKey ^= pieceKeys[us][pawnIndex][pieceCount(makePiece(Us, Figure::PAWN)) - 1];
+        materialKey ^= pieceKeys[us][promotionIndex][pieceCount(promotion)];
+    }
+
+    // 6bis) Castle --> the rook moves as well (h-file to f-file, or a-file to d-file)
+    if (move.isCastle()) {
+        if (to == kingFrom + 2) {
+            nonPawnDelta[us] ^= pieceKeys[us][rookIndex][kingFrom + 3] ^ pieceKeys[us][rookIndex][kingFrom + 1];
+        } else {
+            nonPawnDelta[us] ^= pieceKeys[us][rookIndex][kingFrom - 4] ^ pieceKeys[us][rookIndex][kingFrom - 1];
+        }
+    }
+
+    pawnKey ^= pawnDelta;
+    nonPawnKey[0] ^= nonPawnDelta[0];
+    nonPawnKey[1] ^= nonPawnDelta[1];
+    zobristKey ^= pawnDelta ^ nonPawnDelta[0] ^ nonPawnDelta[1];
+
+    // 7) Update castling rights
+    if (castlingRights != newCastlingRights) {
+        zobristKey ^= ZOBRIST.castlingKeys[castlingRights];
+        zobristKey ^= ZOBRIST.castlingKeys[newCastlingRights];
+    }
+
+    // 8) Update en passant square
+    if (enPassantSquare != newEnPassantSquare) {
+        if (enPassantSquare < 64) { // valid en passant square
+            zobristKey ^= ZOBRIST.enPassantKeys[getCol(enPassantSquare)];
+        }
+        if (newEnPassantSquare < 64) { // valid en passant square
+            zobristKey ^= ZOBRIST.enPassantKeys[getCol(newEnPassantSquare)];
+        }
+    }
+
+    // 9) Update active color
+    zobristKey ^= ZOBRIST.activeColorKey;
+}
+
+
+
+// ------------------------- //
+// !-- Virtual Interface --! //
+// ------------------------- //
+
+/**
+ * For code that needs to hold any kind of position behind a pointer. Costs a virtual call per method,
+ * keep it out of the search.
+ */
+class PositionInterface {
+    public:
+        virtual ~PositionInterface() = default;
+
+        virtual Piece getPieceAt(Square square) const = 0;
+        virtual Color getActiveColor() const = 0;
+        virtual uint64_t getZobristKey() const = 0;
+        virtual std::string toFEN() const = 0;
+        virtual void play(const Move& move) = 0;
+        virtual void unplay(const Move& move) = 0;
+};
+
+/**
+ * Implements PositionInterface by forwarding to a concrete position (which it does not own)
+ */
+template<typename P>
+class PositionAdapter final : public PositionInterface {
+    private:
+        P& position;
+
+    public:
+        PositionAdapter(P& position) : position(position) {}
+
+        Piece getPieceAt(Square square) const override {return position.getPieceAt(square);}
+        Color getActiveColor() const override {return position.getActiveColor();}
+        uint64_t getZobristKey() const override {return position.getZobristKey();}
+        std::string toFEN() const override {return position.toFEN();}
+        void play(const Move& move) override {position.play(move);}
+        void unplay(const Move& move) override {position.unplay(move);}
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,36 @@
+#ifndef SEE_HPP
+#define SEE_HPP
+
+/**
+ * Static exchange evaluation: the material balance of the captures on the target square of a move,
+ * each side recapturing with its least valuable piece and free to stop when going on would lose.
+ * Sliders hidden behind the pieces that capture (x-rays) join in as the square opens up.
+ * Pins are not looked at, and a king only recaptures on an undefended square.
+ */
+
+#include "position.hpp"
+
+
+/**
+ * Rough material values, for move ordering and exchanges. Indexed by Figure, the king is never captured.
+ */
+inline constexpr int32_t PIECE_VALUES[7] = {0, 100, 320, 330, 500, 900, 0};
+
+inline constexpr int32_t getPieceValue(Piece piece) {
+    return PIECE_VALUES[static_cast<uint32_t>(getFigure(piece))];
+}
+
+/**
+ * Value of the exchange started by the move (which must be legal here), for the side playing it.
+ * Castling is worth 0, a promotion counts the new piece minus the pawn.
+ */
+int32_t see(const Position& position, const Move& move);
+
+/**
+ * Same as see(position, move) >= threshold, but faster: the exchange is stopped as soon as the answer is
+ * known, most of the time before the second capture.
+ */
+bool seeGE(const Position& position, const Move& move, int32_t threshold);
+
+
+#endif
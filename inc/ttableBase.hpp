@@ -0,0 +1,187 @@
+#ifndef TTABLEBASE_HPP
+#define TTABLEBASE_HPP
+
+/**
+ * Transposition table: what the search learnt about a position (best move, score, depth), kept by
+ * zobrist key, to reuse it when the position comes back through another move order or at the next
+ * iteration.
+ *
+ * The table is an array of 64 bytes buckets, aligned on cache lines, each holding 5 compact entries.
+ * The high bits of the key pick the bucket, and its low 32 bits identify the entry inside it (through the
+ * check word, below): a probe costs a single memory fetch. When the bucket is full, the entry replaced is the least useful one: shallow, or left by an
+ * old search. The table is never cleared between moves: a generation counter is bumped at each search, and
+ * the entries of the previous generations are recycled first.
+ *
+ * All the search threads share the table without any lock. An entry is a 64 bits data word and a 32 bits
+ * check word, each read and written in one go (relaxed atomics: plain loads and stores, no locked
+ * instruction), but a reader may see the data of one write with the check of another. The check is
+ * 32 bits of the key XOR-ed with the data it was written with, so such a torn entry does not match the key
+ * it is probed with: it is a miss, never a wrong move or score.
+ *
+ * The table can be saved to a file and loaded back by the next process, so that a long analysis restarts at
+ * full depth. The file is the buckets as they are in memory, behind a header with the table size and the
+ * zobrist seed: a snapshot of another size, another layout or other keys is rejected rather than loaded.
+ */
+
+#include "move.hpp"
+#include "hashMemory.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+
+
+/**
+ * What the score of an entry is: exact, or a bound from a cutoff
+ */
+enum class Bound : uint8_t {
+    NONE = 0,
+    UPPER = 1, // fail low: the score is at most this
+    LOWER = 2, // fail high: the score is at least this
+    EXACT = 3,
+};
+
+/**
+ * Content of an entry, as handed out by probe
+ */
+struct TTData {
+    PackedMove move;
+    int16_t score; // as stored: mate scores are relative to the node, the search adjusts them
+    int16_t eval; // static evaluation
+    int depth;
+    Bound bound;
+};
+
+class TranspositionTable {
+    public:
+        static constexpr int DEPTH_OFFSET = -8; // lowest depth that can be stored + 1 (quiescence depths are negative)
+
+    private:
+        /**
+         * Data word of an entry: move | score << 16 | eval << 32 | depth8 << 48 | generationBound << 56.
+         * depth8 = depth - DEPTH_OFFSET, 0 for an empty entry (the word is 0). generationBound holds the
+         * generation in its high 5 bits and the Bound in its low 2.
+         */
+        static uint64_t makeData(PackedMove move, int16_t score, int16_t eval, uint8_t depth8, uint8_t generationBound) {
+            return static_cast<uint64_t>(move.move) | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16
+                 | static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32 | static_cast<uint64_t>(depth8) << 48
+                 | static_cast<uint64_t>(generationBound) << 56;
+        }
+        static uint8_t getDepth8(uint64_t data) {return static_cast<uint8_t>(data >> 48);}
+        static uint8_t getGenerationBound(uint64_t data) {return static_cast<uint8_t>(data >> 56);}
+
+        /**
+         * Check word: low 32 bits of the key (the high ones pick the bucket), XOR-ed with the data
+         */
+        static uint32_t getCheck(uint64_t key, uint64_t data) {
+            return static_cast<uint32_t>(key) ^ static_cast<uint32_t>(data) ^ static_cast<uint32_t>(data >> 32);
+        }
+
+        static constexpr size_t ENTRIES_PER_BUCKET = 5;
+
+        struct alignas(64) Bucket {
+            std::atomic<uint64_t> data[ENTRIES_PER_BUCKET];
+            std::atomic<uint32_t> checks[ENTRIES_PER_BUCKET];
+        };
+        static_assert(sizeof(Bucket) == 64, "a bucket is a cache line");
+
+        static constexpr uint8_t GENERATION_DELTA = 1 << 3; // the bits below hold the bound
+        static constexpr uint8_t GENERATION_MASK = 0xFF & ~(GENERATION_DELTA - 1);
+
+        HashMemory memory; // huge pages when possible
+        Bucket* buckets = nullptr;
+        size_t bucketCount = 0;
+        uint8_t generation = 0; // multiple of GENERATION_DELTA, only changed between searches
+
+        /**
+         * High bits of the key for the bucket (any bucket count works), low bits for the check
+         */
+        Bucket& getBucket(uint64_t key) const {
+            return buckets[getBucketIndex(key, bucketCount)];
+        }
+
+        /**
+         * Searches since the entry was written, modulo 32
+         */
+        uint8_t getAge(uint64_t data) const {
+            // + 255 + GENERATION_DELTA: the bound bits of the entry do not borrow from the generation bits
+            return static_cast<uint8_t>(((255 + GENERATION_DELTA + generation - getGenerationBound(data)) & GENERATION_MASK) / GENERATION_DELTA);
+        }
+
+        /**
+         * Header and buckets into that file, see save
+         */
+        void writeSnapshot(const std::string& path) const;
+
+    public:
+        /**
+         * As many buckets as fit in the budget (at least one)
+         */
+        TranspositionTable(size_t megabytes, unsigned threads = 1);
+
+        static constexpr size_t FALLBACK_MEGABYTES = 1;
+
+        /**
+         * New size, the content is lost. Only between searches (UCI setoption Hash).
+         * @throws std::bad_alloc if there is not enough memory: the table is then an empty FALLBACK_MEGABYTES one
+         */
+        void resize(size_t megabytes, unsigned threads = 1);
+
+        /**
+         * Empties the table with that many threads (UCI ucinewgame). Only between searches.
+         */
+        void clear(unsigned threads = 1);
+
+        bool usesHugePages() const {return memory.usesHugePages();}
+
+        /**
+         * For Position::setPrefetchTarget. Outdated by resize: set it again.
+         */
+        PrefetchTarget getPrefetchTarget() const {
+            return {reinterpret_cast<const char*>(buckets), bucketCount, sizeof(Bucket)};
+        }
+
+        /**
+         * To call before each search (not each iteration): the entries written until now become older
+         */
+        void newSearch() {generation += GENERATION_DELTA;}
+
+        size_t getBucketCount() const {return bucketCount;}
+        size_t getEntryCount() const {return bucketCount * ENTRIES_PER_BUCKET;}
+
+        /**
+         * Fills data and returns true if the position is in the table. The move may come from another
+         * position with the same 32 key bits in the same bucket: check it with isLegal before playing it.
+         */
+        bool probe(uint64_t key, TTData& data) const;
+
+        /**
+         * Writes what the search found for the position. An entry of the same position is refreshed (its move
+         * kept if the new one is null), unless it is clearly deeper; otherwise the shallowest / oldest entry
+         * of the bucket is replaced.
+         */
+        void store(uint64_t key, int depth, Bound bound, int16_t score, int16_t eval, PackedMove move);
+
+        /**
+         * Per mille of the entries written by the current search, sampled on the first buckets (UCI hashfull)
+         */
+        int getHashfull() const;
+
+        /**
+         * Writes the table to the file (a temporary file renamed at the end: an interrupted save leaves the
+         * old snapshot). Only between searches.
+         * @throws std::runtime_error if the file cannot be written
+         */
+        void save(const std::string& path) const;
+
+        /**
+         * Replaces the content of the table by the snapshot, which must have the same size (resize first).
+         * Only between searches. The table is left untouched if the snapshot is rejected.
+         * @throws std::runtime_error if the file cannot be read, or is not a snapshot of this table size, bucket
+         * layout and zobrist keys
+         */
+        void load(const std::string& path);
+};
+
+
+#endif
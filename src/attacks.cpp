@@ -0,0 +1,134 @@
+#include "attacks.hpp"
+#include <stdexcept>
+
+
+
+// --------------------- //
+// !-- Magic numbers --! //
+// --------------------- //
+
+/**
+ * Found offline by trial and error (random sparse numbers until no two occupancies with different attacks
+ * share an index). With one index per relevant occupancy, the table for a square holds 2^popCount(mask) entries,
+ * exactly the range of the PEXT index: both backends share the same tables, only the entry order differs.
+ */
+static const uint64_t ROOK_MAGIC_NUMBERS[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+static const uint64_t BISHOP_MAGIC_NUMBERS[64] = {
+    0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+    0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+    0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+    0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+    0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+    0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+    0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+    0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+    0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+    0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+    0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+    0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+    0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+    0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+    0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+    0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL
+};
+
+SliderBackend sliderBackend = SliderBackend::MAGIC;
+Magic rookMagics[64];
+Magic bishopMagics[64];
+
+static Bitboard rookTable[0x19000]; // 102400 = sum over squares of 2^(relevant rook blockers)
+static Bitboard bishopTable[0x1480]; // 5248
+
+
+
+// ---------------------- //
+// !-- Initialization --! //
+// ---------------------- //
+
+Bitboard slidingAttacks(Square square, Bitboard occupied, bool isRook) {
+    static const int ROOK_DIRECTIONS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    static const int BISHOP_DIRECTIONS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    const int (*directions)[2] = isRook ? ROOK_DIRECTIONS : BISHOP_DIRECTIONS;
+
+    Bitboard attacks = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (Square sq = offsetSquare(square, directions[i][0], directions[i][1]); sq < 64; sq = offsetSquare(sq, directions[i][0], directions[i][1])) {
+            attacks |= squareBB(sq);
+            if (occupied & squareBB(sq)) break; // blocked (the blocker itself can be captured)
+        }
+    }
+    return attacks;
+}
+
+template<SliderBackend Backend>
+static void initMagics(Magic magics[64], const uint64_t magicNumbers[64], Bitboard* table, bool isRook) {
+    Bitboard* slice = table;
+    for (Square square = 0; square < 64; ++square) {
+        // a blocker on the edge does not change anything: there is nothing behind it
+        const Bitboard edges = ((RANK_1 | RANK_8) & ~rankBB(square)) | ((FILE_A | FILE_H) & ~fileBB(square));
+
+        Magic& m = magics[square];
+        m.mask = slidingAttacks(square, 0, isRook) & ~edges;
+        m.magic = magicNumbers[square];
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = slice;
+
+        // enumerate all subsets of the mask (carry-rippler trick)
+        Bitboard blockers = 0;
+        do {
+            m.attacks[m.index<Backend>(blockers)] = slidingAttacks(square, blockers, isRook);
+            blockers = (blockers - m.mask) & m.mask;
+        } while (blockers);
+
+        slice += 1ULL << popCount(m.mask);
+    }
+}
+
+SliderBackend detectSliderBackend() {
+#if CHESS_HAS_PEXT
+    if (__builtin_cpu_supports("bmi2")) {
+        return SliderBackend::PEXT;
+    }
+#endif
+    return SliderBackend::MAGIC;
+}
+
+void initSliders(SliderBackend backend) {
+    if (backend == SliderBackend::PEXT && detectSliderBackend() != SliderBackend::PEXT) {
+        throw std::runtime_error("PEXT slider backend requires a CPU with BMI2");
+    }
+    if (backend == SliderBackend::PEXT) {
+        initMagics<SliderBackend::PEXT>(rookMagics, ROOK_MAGIC_NUMBERS, rookTable, true);
+        initMagics<SliderBackend::PEXT>(bishopMagics, BISHOP_MAGIC_NUMBERS, bishopTable, false);
+    } else {
+        initMagics<SliderBackend::MAGIC>(rookMagics, ROOK_MAGIC_NUMBERS, rookTable, true);
+        initMagics<SliderBackend::MAGIC>(bishopMagics, BISHOP_MAGIC_NUMBERS, bishopTable, false);
+    }
+    sliderBackend = backend; // the tables are in this backend's order now
+}
+
+/**
+ * Fills the slider tables when the program starts.
+ */
+static const bool slidersInitialized = [] {
+    initSliders(detectSliderBackend());
+    return true;
+}();
@@ -0,0 +1,250 @@
+#include "epd.hpp"
+#include "movegen.hpp"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+
+// ----------------- //
+// !-- EPD Lines --! //
+// ----------------- //
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * Index right after the field starting at (or after the spaces following) pos
+ */
+static size_t skipField(std::string_view line, size_t pos) {
+    while (pos < line.size() && isSpace(line[pos])) pos++;
+    while (pos < line.size() && !isSpace(line[pos])) pos++;
+    return pos;
+}
+
+static bool isNumber(std::string_view field) {
+    return !field.empty() && std::all_of(field.begin(), field.end(), [](char c) {return c >= '0' && c <= '9';});
+}
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && isSpace(text.front())) text.remove_prefix(1);
+    while (!text.empty() && isSpace(text.back())) text.remove_suffix(1);
+    return text;
+}
+
+uint32_t EPDBatch::addText(std::string_view value) {
+    if (text.size() + value.size() >= EPDRecord::NO_TEXT) {
+        throw std::runtime_error("EPD batch text is larger than 4 GB");
+    }
+    const uint32_t offset = static_cast<uint32_t>(text.size());
+    text.append(value);
+    text.push_back('\0');
+    return offset;
+}
+
+void EPDBatch::append(const EPDBatch& other) {
+    if (text.size() + other.text.size() >= EPDRecord::NO_TEXT) {
+        throw std::runtime_error("EPD batch text is larger than 4 GB");
+    }
+    const uint32_t shift = static_cast<uint32_t>(text.size());
+    text += other.text;
+    records.reserve(records.size() + other.records.size());
+    for (EPDRecord record : other.records) {
+        if (record.id != EPDRecord::NO_TEXT) record.id += shift;
+        if (record.comment != EPDRecord::NO_TEXT) record.comment += shift;
+        records.push_back(record);
+    }
+    errors += other.errors;
+}
+
+bool EPDBatch::parseLine(std::string_view line, Position& position) {
+    line = trim(line);
+    if (line.empty() || line.front() == '#') {
+        return true;
+    }
+
+    // !-- Position --! // 4 fields, then the clocks if there are numbers after them
+    size_t fenEnd = skipField(line, 0);
+    for (int field = 1; field < 4; ++field) fenEnd = skipField(line, fenEnd);
+    for (int clock = 0; clock < 2; ++clock) {
+        const size_t next = skipField(line, fenEnd);
+        if (!isNumber(trim(line.substr(fenEnd, next - fenEnd)))) break;
+        fenEnd = next;
+    }
+    if (position.parseFEN(line.substr(0, fenEnd)) != FENError::NONE || popCount(position.getOccupied()) > 32) {
+        errors++;
+        return false;
+    }
+
+    // !-- Operations --! // opcode operands; (operands may be quoted, with ';' inside)
+    EPDRecord record;
+    const size_t textSize = text.size();
+    std::string_view operations = line.substr(fenEnd);
+    while (!(operations = trim(operations)).empty()) {
+        const size_t opcodeEnd = std::min(operations.find_first_of(" \t;"), operations.size());
+        const std::string_view opcode = operations.substr(0, opcodeEnd);
+        size_t end = opcodeEnd;
+        bool quoted = false;
+        while (end < operations.size() && (quoted || operations[end] != ';')) {
+            if (operations[end] == '"') quoted = !quoted;
+            end++;
+        }
+        std::string_view operands = trim(operations.substr(opcodeEnd, end - opcodeEnd));
+        operations.remove_prefix(std::min(end + 1, operations.size()));
+
+        if (opcode == "bm" || opcode == "am") {
+            PackedMove* moves = opcode == "bm" ? record.bestMoves : record.avoidMoves;
+            size_t count = 0;
+            while (!(operands = trim(operands)).empty()) {
+                const size_t tokenEnd = skipField(operands, 0);
+                const std::string_view token = operands.substr(0, tokenEnd);
+                operands.remove_prefix(tokenEnd);
+                Move move = parseSANMove(position, token);
+                if (move.isNull()) move = parseUCIMove(position, token);
+                if (move.isNull()) {
+                    text.resize(textSize);
+                    errors++;
+                    return false;
+                }
+                if (count < EPDRecord::MAX_MOVES) moves[count++] = PackedMove(move);
+            }
+        } else if (opcode == "id" || opcode == "c0") {
+            if (operands.size() >= 2 && operands.front() == '"' && operands.back() == '"') {
+                operands = operands.substr(1, operands.size() - 2);
+            }
+            (opcode == "id" ? record.id : record.comment) = addText(operands);
+        }
+    }
+
+    record.position = position.pack();
+    records.push_back(record);
+    return true;
+}
+
+
+
+// ----------------- //
+// !-- Streaming --! //
+// ----------------- //
+
+/**
+ * Closes the file / unmaps the window whatever happens in the consumer
+ */
+struct FileGuard {
+    int fd;
+    ~FileGuard() {close(fd);}
+};
+
+struct MappingGuard {
+    void* address;
+    size_t length;
+    ~MappingGuard() {munmap(address, length);}
+};
+
+/**
+ * Parses the lines of a chunk, which ends with a '\n' or at the end of the file
+ */
+static void parseChunk(std::string_view chunk, EPDBatch& batch, Position& position) {
+    batch.clear();
+    while (!chunk.empty()) {
+        const size_t end = std::min(chunk.find('\n'), chunk.size());
+        batch.parseLine(chunk.substr(0, end), position);
+        chunk.remove_prefix(std::min(end + 1, chunk.size()));
+    }
+}
+
+void streamEPD(const std::string& path, const std::function<void(const EPDBatch&)>& consumer, const EPDOptions& options) {
+    const FileGuard file{open(path.c_str(), O_RDONLY)};
+    struct stat status;
+    if (file.fd < 0 || fstat(file.fd, &status) != 0) {
+        throw std::runtime_error("Cannot open EPD file " + path);
+    }
+    const size_t fileSize = static_cast<size_t>(status.st_size);
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t windowBytes = std::max((options.windowBytes + pageSize - 1) / pageSize, size_t(16)) * pageSize;
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    constexpr size_t MIN_CHUNK_BYTES = 1 << 16; // below that, a thread costs more than it saves
+
+    // allocated once, the batches keep their capacity from a window to the next
+    std::vector<EPDBatch> batches(threads);
+    std::vector<Position> positions(threads);
+    std::vector<std::string_view> chunks(threads);
+    std::vector<std::exception_ptr> errors(threads);
+
+    size_t offset = 0; // first byte not parsed yet, always at the start of a line
+    while (offset < fileSize) {
+        // 1) Map the window, the mapping has to start on a page
+        const size_t mapStart = offset / pageSize * pageSize;
+        const size_t mapLength = std::min(windowBytes, fileSize - mapStart);
+        void* address = mmap(nullptr, mapLength, PROT_READ, MAP_PRIVATE, file.fd, static_cast<off_t>(mapStart));
+        if (address == MAP_FAILED) {
+            throw std::runtime_error("Cannot map EPD file " + path);
+        }
+        const MappingGuard mapping{address, mapLength};
+        madvise(address, mapLength, MADV_SEQUENTIAL);
+        std::string_view window(static_cast<const char*>(address) + (offset - mapStart), mapLength - (offset - mapStart));
+
+        // 2) Stop at the last complete line, the next window starts from there
+        if (mapStart + mapLength < fileSize) {
+            const size_t lastNewline = window.rfind('\n');
+            if (lastNewline == std::string_view::npos) {
+                throw std::runtime_error("EPD line longer than the window in " + path);
+            }
+            window = window.substr(0, lastNewline + 1);
+        }
+
+        // 3) Line aligned chunks, parsed in parallel
+        const size_t chunkCount = std::clamp<size_t>(window.size() / MIN_CHUNK_BYTES, 1, threads);
+        size_t chunkStart = 0;
+        for (size_t i = 0; i < chunkCount; ++i) {
+            size_t chunkEnd = window.size();
+            if (i + 1 < chunkCount) {
+                chunkEnd = std::max(chunkStart, window.size() * (i + 1) / chunkCount);
+                chunkEnd = std::min(window.find('\n', chunkEnd), window.size() - 1) + 1;
+            }
+            chunks[i] = window.substr(chunkStart, chunkEnd - chunkStart);
+            chunkStart = chunkEnd;
+        }
+        // an exception must not leave its thread (std::terminate): kept, and rethrown here once all are joined
+        auto parse = [&](size_t i) {
+            try {
+                parseChunk(chunks[i], batches[i], positions[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        };
+        std::fill(errors.begin(), errors.end(), nullptr);
+        std::vector<std::thread> pool;
+        for (size_t i = 1; i < chunkCount; ++i) {
+            try {
+                pool.emplace_back(parse, i);
+            } catch (const std::system_error&) {
+                parse(i); // no thread available: this one parses it
+            }
+        }
+        parse(0);
+        for (std::thread& thread : pool) thread.join();
+        for (const std::exception_ptr& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+
+        // 4) Hand the batches over in file order
+        for (size_t i = 0; i < chunkCount; ++i) {
+            consumer(batches[i]);
+        }
+        offset += window.size();
+    }
+}
+
+EPDBatch loadEPD(const std::string& path, const EPDOptions& options) {
+    EPDBatch all;
+    streamEPD(path, [&all](const EPDBatch& batch) {all.append(batch);}, options);
+    return all;
+}
@@ -0,0 +1,93 @@
+#include "hashMemory.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <sys/mman.h>
+
+
+
+// ------------------ //
+// !-- Allocation --! //
+// ------------------ //
+
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+static size_t roundUp(size_t bytes, size_t alignment) {
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+HashMemory::HashMemory(size_t size) {
+    if (size >= HUGE_PAGE_SIZE) {
+        bytes = roundUp(size, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            mapped = hugePages = true;
+            return;
+        }
+        memory = nullptr; // none reserved: transparent huge pages
+#endif
+#ifdef MADV_HUGEPAGE
+        memory = std::aligned_alloc(HUGE_PAGE_SIZE, bytes);
+        if (memory) {
+            hugePages = madvise(memory, bytes, MADV_HUGEPAGE) == 0;
+            return;
+        }
+#endif
+    }
+    bytes = roundUp(size, CACHE_LINE_SIZE);
+    memory = std::aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+}
+
+void HashMemory::release() {
+    if (mapped) munmap(memory, bytes);
+    else std::free(memory);
+    memory = nullptr;
+    bytes = 0;
+    mapped = hugePages = false;
+}
+
+HashMemory::HashMemory(HashMemory&& other) noexcept
+    : memory(std::exchange(other.memory, nullptr)), bytes(std::exchange(other.bytes, 0)),
+      mapped(std::exchange(other.mapped, false)), hugePages(std::exchange(other.hugePages, false)) {}
+
+HashMemory& HashMemory::operator=(HashMemory&& other) noexcept {
+    if (this != &other) {
+        release();
+        memory = std::exchange(other.memory, nullptr);
+        bytes = std::exchange(other.bytes, 0);
+        mapped = std::exchange(other.mapped, false);
+        hugePages = std::exchange(other.hugePages, false);
+    }
+    return *this;
+}
+
+
+
+// ---------------- //
+// !-- Clearing --! //
+// ---------------- //
+
+void clearHashMemory(void* memory, size_t bytes, unsigned threads) {
+    char* start = static_cast<char*>(memory);
+    threads = std::max(1u, threads);
+    if (threads == 1 || bytes < HUGE_PAGE_SIZE) {
+        std::memset(start, 0, bytes);
+        return;
+    }
+    // slices on huge page boundaries, so that two threads never fault the same page
+    const size_t slice = roundUp(bytes / threads, HUGE_PAGE_SIZE);
+    std::vector<std::thread> pool;
+    for (size_t offset = 0; offset < bytes; offset += slice) {
+        pool.emplace_back([=]() {std::memset(start + offset, 0, std::min(slice, bytes - offset));});
+    }
+    for (std::thread& thread : pool) thread.join();
+}
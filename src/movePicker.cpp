@@ -0,0 +1,120 @@
+#include "movePicker.hpp"
+
+
+
+// --------------- //
+// !-- Scoring --! //
+// --------------- //
+
+static inline bool isQuiet(const Move& move) {
+    return !move.isCapture() && !move.isEnPassant() && !move.isPromotion();
+}
+
+void MovePicker::scoreCaptures() {
+    for (size_t i = 0; i < moves.size(); ++i) {
+        const Move& move = moves[i];
+        const Figure victim = move.isEnPassant() ? Figure::PAWN : getFigure(move.getCapture());
+        int32_t score = 16 * PIECE_VALUES[static_cast<uint32_t>(victim)] - PIECE_VALUES[static_cast<uint32_t>(getFigure(move.getPiece()))];
+        if (move.isPromotion()) {
+            score += 16 * PIECE_VALUES[static_cast<uint32_t>(getFigure(move.getPromotion()))];
+        }
+        moves.setScore(i, score);
+    }
+}
+
+void MovePicker::scoreQuiets() {
+    const uint32_t colorIndex = getColorIndex(position.getActiveColor());
+    for (size_t i = 0; i < moves.size(); ++i) {
+        moves.setScore(i, history ? (*history)[colorIndex][moves[i].getFrom()][moves[i].getTo()] : 0);
+    }
+}
+
+Move MovePicker::pickBest() {
+    size_t best = current;
+    for (size_t i = current + 1; i < moves.size(); ++i) {
+        if (moves.getScore(i) > moves.getScore(best)) best = i;
+    }
+    moves.swap(current, best);
+    return moves[current++];
+}
+
+
+
+// -------------- //
+// !-- Stages --! //
+// -------------- //
+
+MovePicker::MovePicker(const Position& position, Move ttMove, Move killer1, Move killer2, const ButterflyHistory* history)
+    : position(position), ttMove(ttMove), killers{killer1, killer2}, history(history), stage(PickerStage::TT_MOVE) {
+    if (!ttMove.isNull() && !isLegal(position, ttMove)) {
+        this->ttMove = Move(); // from another position (hash collision), or simply none
+    }
+    if (killers[1] == killers[0]) {
+        killers[1] = Move();
+    }
+    for (Move& killer : killers) {
+        if (killer.isNull() || killer == this->ttMove || !isQuiet(killer) || !isLegal(position, killer)) {
+            killer = Move();
+        }
+    }
+}
+
+Move MovePicker::next() {
+    switch (stage) {
+        case PickerStage::TT_MOVE:
+            stage = PickerStage::GENERATE_CAPTURES;
+            if (!ttMove.isNull()) return ttMove;
+            [[fallthrough]];
+
+        case PickerStage::GENERATE_CAPTURES:
+            moves.clear();
+            generateLegalMoves<GenType::CAPTURES>(position, moves);
+            scoreCaptures();
+            current = 0;
+            stage = PickerStage::GOOD_CAPTURES;
+            [[fallthrough]];
+
+        case PickerStage::GOOD_CAPTURES:
+            while (current < moves.size()) {
+                const Move move = pickBest();
+                if (move == ttMove) continue;
+                if (seeGE(position, move, 0)) return move;
+                badCaptures.push_back(move); // still in MVV-LVA order
+            }
+            stage = PickerStage::KILLERS;
+            [[fallthrough]];
+
+        case PickerStage::KILLERS:
+            while (currentKiller < 2) {
+                const Move killer = killers[currentKiller++];
+                if (!killer.isNull()) return killer;
+            }
+            stage = PickerStage::GENERATE_QUIETS;
+            [[fallthrough]];
+
+        case PickerStage::GENERATE_QUIETS:
+            moves.clear();
+            generateLegalMoves<GenType::QUIETS>(position, moves);
+            scoreQuiets();
+            current = 0;
+            stage = PickerStage::QUIETS;
+            [[fallthrough]];
+
+        case PickerStage::QUIETS:
+            while (current < moves.size()) {
+                const Move move = pickBest();
+                if (move != ttMove && move != killers[0] && move != killers[1]) return move;
+            }
+            stage = PickerStage::BAD_CAPTURES;
+            [[fallthrough]];
+
+        case PickerStage::BAD_CAPTURES:
+            if (currentBad < badCaptures.size()) return badCaptures[currentBad++];
+            stage = PickerStage::END;
+            [[fallthrough]];
+
+        case PickerStage::END:
+            return Move();
+    }
+    return Move();
+}
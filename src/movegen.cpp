@@ -0,0 +1,413 @@
+#include "movegen.hpp"
+
+
+
+// --------------- //
+// !-- Helpers --! //
+// --------------- //
+
+static const Piece NO_PIECE = makePiece(Color::WHITE, Figure::EMPTY);
+
+/**
+ * Moves every square of the bitboard one row forward, from the point of view of Us
+ */
+template<Color Us>
+static inline Bitboard pawnPush(Bitboard bb) {
+    return Us == Color::WHITE ? bb << 8 : bb >> 8;
+}
+
+/**
+ * Adds a pawn move, or its four promotions when it reaches the last row
+ */
+template<Color Us>
+static inline void addPawnMoves(const Position& position, Square from, Square to, MoveList& moves) {
+    constexpr uint32_t lastRow = Us == Color::WHITE ? 7 : 0;
+    constexpr Piece pawn = makePiece(Us, Figure::PAWN);
+    const Piece captured = position.getPieceAt(to);
+    if (getRow(to) == lastRow) {
+        moves.emplace_back(from, to, pawn, captured, makePiece(Us, Figure::QUEEN), Move::PROMOTION_FLAG);
+        moves.emplace_back(from, to, pawn, captured, makePiece(Us, Figure::ROOK), Move::PROMOTION_FLAG);
+        moves.emplace_back(from, to, pawn, captured, makePiece(Us, Figure::BISHOP), Move::PROMOTION_FLAG);
+        moves.emplace_back(from, to, pawn, captured, makePiece(Us, Figure::KNIGHT), Move::PROMOTION_FLAG);
+    } else {
+        moves.emplace_back(from, to, pawn, captured, NO_PIECE, 0);
+    }
+}
+
+/**
+ * Everything the king cares about, computed once per position
+ */
+struct KingSafety {
+    Square kingSquare;
+    Bitboard checkers; // enemy pieces giving check
+    Bitboard pinned; // our pieces that cannot leave the line joining them to our king
+    Bitboard evasionMask; // where the other pieces may go: everywhere, or capture / block the only checker
+};
+
+template<Color Us, SliderBackend Backend>
+static inline KingSafety getKingSafety(const Position& position, Bitboard occupied) {
+    constexpr Color Them = ~Us;
+    KingSafety safety;
+    safety.kingSquare = position.getKingSquare(Us);
+    safety.checkers = position.getAttackersBy<Them, Backend>(safety.kingSquare, occupied);
+
+    safety.pinned = 0;
+    Bitboard snipers = (rookAttacks<Backend>(safety.kingSquare, 0) & (position.getPieces(Them, Figure::ROOK) | position.getPieces(Them, Figure::QUEEN)))
+                     | (bishopAttacks<Backend>(safety.kingSquare, 0) & (position.getPieces(Them, Figure::BISHOP) | position.getPieces(Them, Figure::QUEEN)));
+    while (snipers) {
+        const Square sniper = popLsb(snipers);
+        const Bitboard blockers = between(safety.kingSquare, sniper) & occupied;
+        if (blockers && !moreThanOne(blockers)) {
+            safety.pinned |= blockers & position.getPieces(Us); // a single enemy blocker pins nothing
+        }
+    }
+
+    safety.evasionMask = safety.checkers ? between(safety.kingSquare, lsb(safety.checkers)) | safety.checkers : ~0ULL;
+    return safety;
+}
+
+/**
+ * Castling: nothing between king and rook, and the king does not cross an attacked square. Not in check.
+ */
+template<Color Us, bool KingSide, SliderBackend Backend>
+static inline bool canCastle(const Position& position, Bitboard occupied) {
+    constexpr Color Them = ~Us;
+    constexpr Square kingFrom = Us == Color::WHITE ? 4 : 60;
+    constexpr uint32_t right = KingSide ? (Us == Color::WHITE ? 0b1000 : 0b0010) : (Us == Color::WHITE ? 0b0100 : 0b0001);
+    constexpr Square rookFrom = KingSide ? kingFrom + 3 : kingFrom - 4;
+    constexpr int step = KingSide ? 1 : -1;
+    constexpr Bitboard path = KingSide ? squareBB(kingFrom + 1) | squareBB(kingFrom + 2)
+                                       : squareBB(kingFrom - 1) | squareBB(kingFrom - 2) | squareBB(kingFrom - 3);
+
+    return (position.getCastlingRights() & right)
+        && position.getPieceAt(rookFrom) == makePiece(Us, Figure::ROOK)
+        && !(occupied & path)
+        && !position.getAttackersBy<Them, Backend>(kingFrom + step, occupied)
+        && !position.getAttackersBy<Them, Backend>(kingFrom + 2 * step, occupied);
+}
+
+/**
+ * En passant removes two pawns from the row at once, so look at the king with the resulting occupancy.
+ * This also covers evasions (taking the pawn that just gave check) and pins.
+ */
+template<Color Us, SliderBackend Backend>
+static inline bool isLegalEnPassant(const Position& position, Square kingSquare, Bitboard occupied, Square from, Square to) {
+    const Square capturedSquare = getRow(from) * 8 + getCol(to);
+    const Bitboard occupiedAfter = (occupied ^ squareBB(from) ^ squareBB(capturedSquare)) | squareBB(to);
+    return !(position.getAttackersBy<~Us, Backend>(kingSquare, occupiedAfter) & ~squareBB(capturedSquare));
+}
+
+
+
+// ----------------------- //
+// !-- Legal Generator --! //
+// ----------------------- //
+
+template<Color Us, GenType Type, SliderBackend Backend>
+void generateLegalMoves(const Position& position, MoveList& moves) {
+    constexpr Color Them = ~Us;
+    constexpr bool captures = Type != GenType::QUIETS;
+    constexpr bool quiets = Type != GenType::CAPTURES;
+    const Bitboard ours = position.getPieces(Us);
+    const Bitboard theirs = position.getPieces(Them);
+    const Bitboard occupied = ours | theirs;
+
+    // 1) Checkers and pinned pieces
+    const KingSafety safety = getKingSafety<Us, Backend>(position, occupied);
+    const Square kingSquare = safety.kingSquare;
+    const Bitboard pinned = safety.pinned;
+
+    // which squares we look at: the enemy pieces, the empty squares, or both
+    const Bitboard typeMask = (captures ? theirs : 0) | (quiets ? ~occupied : 0);
+
+    // 2) King moves: the king is taken off the board, so that it cannot step back along a slider's line
+    constexpr Piece king = makePiece(Us, Figure::KING);
+    const Bitboard occupiedWithoutKing = occupied ^ squareBB(kingSquare);
+    Bitboard kingTargets = kingAttacks(kingSquare) & typeMask;
+    while (kingTargets) {
+        const Square to = popLsb(kingTargets);
+        if (!position.getAttackersBy<Them, Backend>(to, occupiedWithoutKing)) {
+            moves.emplace_back(kingSquare, to, king, position.getPieceAt(to), NO_PIECE, 0);
+        }
+    }
+
+    if (moreThanOne(safety.checkers)) {
+        return; // double check: only the king can move
+    }
+
+    if (quiets && !safety.checkers) {
+        constexpr Square kingFrom = Us == Color::WHITE ? 4 : 60;
+        if (canCastle<Us, true, Backend>(position, occupied)) moves.emplace_back(kingFrom, kingFrom + 2, king, NO_PIECE, NO_PIECE, Move::CASTLE_FLAG);
+        if (canCastle<Us, false, Backend>(position, occupied)) moves.emplace_back(kingFrom, kingFrom - 2, king, NO_PIECE, NO_PIECE, Move::CASTLE_FLAG);
+    }
+
+    // 3) The other pieces must capture or block the checker, if any
+    const Bitboard evasionMask = safety.evasionMask;
+    const Bitboard targetMask = typeMask & evasionMask;
+
+    // 4) Knights, bishops, rooks and queens: pinned ones stay on the line of their king
+    for (Figure figure : {Figure::KNIGHT, Figure::BISHOP, Figure::ROOK, Figure::QUEEN}) {
+        const Piece piece = makePiece(Us, figure);
+        Bitboard fromBB = position.getPieces(piece);
+        if (figure == Figure::KNIGHT) {
+            fromBB &= ~pinned; // a pinned knight always leaves the line
+        }
+        while (fromBB) {
+            const Square from = popLsb(fromBB);
+            Bitboard targets = attacksOf<Backend>(figure, from, occupied) & targetMask;
+            if (pinned & squareBB(from)) {
+                targets &= line(kingSquare, from);
+            }
+            while (targets) {
+                const Square to = popLsb(targets);
+                moves.emplace_back(from, to, piece, position.getPieceAt(to), NO_PIECE, 0);
+            }
+        }
+    }
+
+    // 5) Pawns. Promotions go with the captures, even without capturing
+    constexpr Piece pawn = makePiece(Us, Figure::PAWN);
+    constexpr int up = Us == Color::WHITE ? 8 : -8;
+    constexpr Bitboard thirdRow = Us == Color::WHITE ? RANK_1 << 16 : RANK_1 << 40;
+    constexpr Bitboard lastRow = Us == Color::WHITE ? RANK_8 : RANK_1;
+    const Bitboard pawns = position.getPieces(pawn);
+
+    Bitboard singlePushes = pawnPush<Us>(pawns) & ~occupied;
+    Bitboard doublePushes = quiets ? pawnPush<Us>(singlePushes & thirdRow) & ~occupied & evasionMask : 0;
+    singlePushes &= evasionMask & ((captures ? lastRow : 0) | (quiets ? ~lastRow : 0));
+    while (singlePushes) {
+        const Square to = popLsb(singlePushes);
+        const Square from = to - up;
+        if ((pinned & squareBB(from)) && !aligned(kingSquare, from, to)) continue;
+        addPawnMoves<Us>(position, from, to, moves);
+    }
+    while (doublePushes) {
+        const Square to = popLsb(doublePushes);
+        const Square from = to - 2 * up;
+        if ((pinned & squareBB(from)) && !aligned(kingSquare, from, to)) continue;
+        moves.emplace_back(from, to, pawn, NO_PIECE, NO_PIECE, Move::DOUBLE_PUSH_FLAG);
+    }
+
+    if (!captures) {
+        return;
+    }
+
+    Bitboard capturers = pawns;
+    while (capturers) {
+        const Square from = popLsb(capturers);
+        Bitboard targets = pawnAttacks(Us, from) & theirs & evasionMask;
+        if (pinned & squareBB(from)) {
+            targets &= line(kingSquare, from);
+        }
+        while (targets) {
+            addPawnMoves<Us>(position, from, popLsb(targets), moves);
+        }
+    }
+
+    // 6) En passant
+    const Square enPassantSquare = position.getEnPassantSquare();
+    if (enPassantSquare < 64) {
+        Bitboard enPassantCapturers = pawnAttacks(Them, enPassantSquare) & pawns;
+        while (enPassantCapturers) {
+            const Square from = popLsb(enPassantCapturers);
+            if (isLegalEnPassant<Us, Backend>(position, kingSquare, occupied, from, enPassantSquare)) {
+                moves.emplace_back(from, enPassantSquare, pawn, NO_PIECE, NO_PIECE, Move::EN_PASSANT_FLAG);
+            }
+        }
+    }
+}
+
+template void generateLegalMoves<Color::WHITE, GenType::CAPTURES, SliderBackend::MAGIC>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::WHITE, GenType::QUIETS, SliderBackend::MAGIC>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::WHITE, GenType::ALL, SliderBackend::MAGIC>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::BLACK, GenType::CAPTURES, SliderBackend::MAGIC>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::BLACK, GenType::QUIETS, SliderBackend::MAGIC>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::BLACK, GenType::ALL, SliderBackend::MAGIC>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::WHITE, GenType::CAPTURES, SliderBackend::PEXT>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::WHITE, GenType::QUIETS, SliderBackend::PEXT>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::WHITE, GenType::ALL, SliderBackend::PEXT>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::BLACK, GenType::CAPTURES, SliderBackend::PEXT>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::BLACK, GenType::QUIETS, SliderBackend::PEXT>(const Position& position, MoveList& moves);
+template void generateLegalMoves<Color::BLACK, GenType::ALL, SliderBackend::PEXT>(const Position& position, MoveList& moves);
+
+
+
+// ---------------------- //
+// !-- Legality Check --! //
+// ---------------------- //
+
+template<Color Us, SliderBackend Backend>
+static bool isLegal(const Position& position, const Move& move) {
+    constexpr Color Them = ~Us;
+    constexpr Square kingFrom = Us == Color::WHITE ? 4 : 60;
+    constexpr int up = Us == Color::WHITE ? 8 : -8;
+    constexpr uint32_t lastRow = Us == Color::WHITE ? 7 : 0;
+
+    const Square from = move.getFrom();
+    const Square to = move.getTo();
+    const Piece piece = move.getPiece();
+    const Piece captured = move.getCapture();
+    const Piece promotion = move.getPromotion();
+    const Figure figure = getFigure(piece);
+    const Bitboard occupied = position.getOccupied();
+
+    // 1) The move must describe this board, with the flags matching its fields
+    if (move != Move(from, to, piece, captured, promotion)) {
+        return false;
+    }
+    if (move.isNull() || getColor(piece) != Us || figure == Figure::EMPTY || position.getPieceAt(from) != piece) {
+        return false;
+    }
+    if (position.getPieceAt(to) != captured) {
+        return false; // also rejects moves landing on our own pieces
+    }
+    if (captured != NO_PIECE && (getColor(captured) != Them || getFigure(captured) == Figure::KING || getFigure(captured) == Figure::EMPTY)) {
+        return false;
+    }
+    const bool reachesLastRow = figure == Figure::PAWN && getRow(to) == lastRow;
+    if (reachesLastRow) {
+        if (getColor(promotion) != Us || getFigure(promotion) < Figure::KNIGHT || getFigure(promotion) > Figure::QUEEN) return false;
+    } else if (promotion != NO_PIECE) {
+        return false;
+    }
+
+    // 2) King moves and castling
+    if (figure == Figure::KING) {
+        if (move.isCastle()) {
+            // the flag only says two columns: the king must stay on its row
+            if (from != kingFrom || (to != kingFrom + 2 && to != kingFrom - 2) || position.getAttackersBy<Them, Backend>(from, occupied)) return false;
+            return to == kingFrom + 2 ? canCastle<Us, true, Backend>(position, occupied) : canCastle<Us, false, Backend>(position, occupied);
+        }
+        return (kingAttacks(from) & squareBB(to)) && !position.getAttackersBy<Them, Backend>(to, occupied ^ squareBB(from));
+    }
+
+    // 3) The piece must be able to get there
+    const KingSafety safety = getKingSafety<Us, Backend>(position, occupied);
+    if (figure == Figure::PAWN) {
+        if (getCol(from) == getCol(to)) {
+            const bool singlePush = to == from + up;
+            const bool doublePush = to == from + 2 * up && getRow(from) == (Us == Color::WHITE ? 1u : 6u) && !(occupied & squareBB(from + up));
+            if ((!singlePush && !doublePush) || captured != NO_PIECE) return false; // pushes never capture
+        } else {
+            if (!(pawnAttacks(Us, from) & squareBB(to))) return false;
+            if (captured == NO_PIECE) {
+                // en passant: the checks and pins are handled with the resulting occupancy
+                return to == position.getEnPassantSquare() && isLegalEnPassant<Us, Backend>(position, safety.kingSquare, occupied, from, to);
+            }
+        }
+    } else if (!(attacksOf<Backend>(figure, from, occupied) & squareBB(to))) {
+        return false;
+    }
+
+    // 4) The king must be safe afterwards
+    if (moreThanOne(safety.checkers) || !(safety.evasionMask & squareBB(to))) {
+        return false;
+    }
+    return !(safety.pinned & squareBB(from)) || aligned(safety.kingSquare, from, to);
+}
+
+template<Color Us>
+static bool isLegal(const Position& position, const Move& move) {
+    return usesPextSliders() ? isLegal<Us, SliderBackend::PEXT>(position, move) : isLegal<Us, SliderBackend::MAGIC>(position, move);
+}
+
+bool isLegal(const Position& position, const Move& move) {
+    return position.getActiveColor() == Color::WHITE ? isLegal<Color::WHITE>(position, move) : isLegal<Color::BLACK>(position, move);
+}
+
+
+
+// -------------------- //
+// !-- Move Parsing --! //
+// -------------------- //
+
+Move parseUCIMove(const Position& position, std::string_view text) {
+    if (text.size() != 4 && text.size() != 5) {
+        return Move();
+    }
+    for (size_t i = 0; i < 4; i += 2) {
+        if (text[i] < 'a' || text[i] > 'h' || text[i + 1] < '1' || text[i + 1] > '8') return Move();
+    }
+    const Square from = (text[1] - '1') * 8 + (text[0] - 'a');
+    const Square to = (text[3] - '1') * 8 + (text[2] - 'a');
+    const Piece piece = position.getPieceAt(from);
+
+    Piece promotion = NO_PIECE;
+    if (text.size() == 5) {
+        Figure figure;
+        switch (text[4]) {
+            case 'n': case 'N': figure = Figure::KNIGHT; break;
+            case 'b': case 'B': figure = Figure::BISHOP; break;
+            case 'r': case 'R': figure = Figure::ROOK; break;
+            case 'q': case 'Q': figure = Figure::QUEEN; break;
+            default: return Move();
+        }
+        promotion = makePiece(getColor(piece), figure);
+    }
+
+    const Move move(from, to, piece, position.getPieceAt(to), promotion); // flags worked out from the fields
+    return isLegal(position, move) ? move : Move();
+}
+
+static Figure getFigureFromSAN(char c) {
+    switch (c) {
+        case 'N': return Figure::KNIGHT;
+        case 'B': return Figure::BISHOP;
+        case 'R': return Figure::ROOK;
+        case 'Q': return Figure::QUEEN;
+        case 'K': return Figure::KING;
+        default: return Figure::EMPTY;
+    }
+}
+
+Move parseSANMove(const Position& position, std::string_view text) {
+    while (!text.empty() && (text.back() == '+' || text.back() == '#' || text.back() == '!' || text.back() == '?')) {
+        text.remove_suffix(1);
+    }
+
+    // !-- Castling --! // the king moves two squares
+    const bool kingSide = text == "O-O" || text == "0-0";
+    if (kingSide || text == "O-O-O" || text == "0-0-0") {
+        const Square from = position.getActiveColor() == Color::WHITE ? 4 : 60;
+        const Move move(from, kingSide ? from + 2 : from - 2, position.getPieceAt(from));
+        return isLegal(position, move) ? move : Move();
+    }
+
+    // !-- Promotion --! // "e8=Q" or "e8Q"
+    Figure promotion = Figure::EMPTY;
+    if (text.size() >= 3 && getFigureFromSAN(text.back()) != Figure::EMPTY) {
+        promotion = getFigureFromSAN(text.back());
+        text.remove_suffix(text[text.size() - 2] == '=' ? 2 : 1);
+    }
+
+    // !-- Piece, origin hints and destination --! //
+    Figure figure = Figure::PAWN;
+    if (!text.empty() && getFigureFromSAN(text.front()) != Figure::EMPTY) {
+        figure = getFigureFromSAN(text.front());
+        text.remove_prefix(1);
+    }
+    if (text.size() < 2 || text[text.size() - 2] < 'a' || text[text.size() - 2] > 'h' || text.back() < '1' || text.back() > '8') {
+        return Move();
+    }
+    const Square to = (text.back() - '1') * 8 + (text[text.size() - 2] - 'a');
+    text.remove_suffix(2);
+    if (!text.empty() && text.back() == 'x') text.remove_suffix(1);
+    int fromCol = -1, fromRow = -1;
+    for (char c : text) {
+        if (c >= 'a' && c <= 'h') fromCol = c - 'a';
+        else if (c >= '1' && c <= '8') fromRow = c - '1';
+        else return Move();
+    }
+
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    Move found;
+    int matches = 0;
+    for (const Move& move : moves) {
+        if (move.getTo() != to || getFigure(move.getPiece()) != figure || getFigure(move.getPromotion()) != promotion) continue;
+        if ((fromCol >= 0 && getCol(move.getFrom()) != static_cast<uint32_t>(fromCol)) || (fromRow >= 0 && getRow(move.getFrom()) != static_cast<uint32_t>(fromRow))) continue;
+        found = move;
+        matches++;
+    }
+    return matches == 1 ? found : Move();
+}
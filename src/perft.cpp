@@ -0,0 +1,218 @@
+#include "perft.hpp"
+#include <atomic>
+#include <thread>
+
+
+
+// ------------- //
+// !-- Suite --! //
+// ------------- //
+
+const std::vector<PerftPosition> PERFT_SUITE = {
+    {"startpos", Position::startpos, {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", {48, 2039, 97862, 4085603, 193690690}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", {14, 191, 2812, 43238, 674624, 11030083, 178633661}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", {6, 264, 9467, 422333, 15833292}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", {44, 1486, 62379, 2103487, 89941194}},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", {46, 2079, 89890, 3894594, 164075551}},
+    {"en passant discovered check", "8/8/8/K2pP2r/8/8/8/7k w - d6 0 2", {6}}, // exd6 would expose the king
+    {"castle through check", "r3k2r/8/8/8/8/8/8/2R1K1R1 b kq - 0 1", {24}}, // c8 and g8 are attacked
+};
+
+
+
+// ------------------- //
+// !-- Perft Table --! //
+// ------------------- //
+
+PerftTable::PerftTable(size_t megabytes) {
+    count = 1;
+    while (2 * count * sizeof(Entry) <= megabytes * 1024 * 1024) count *= 2;
+    entries = std::make_unique<Entry[]>(count);
+    clear();
+}
+
+void PerftTable::clear() {
+    for (size_t i = 0; i < count; ++i) {
+        entries[i].check.store(0, std::memory_order_relaxed);
+        entries[i].data.store(0, std::memory_order_relaxed); // depth 0 is never stored: empty
+    }
+}
+
+
+
+// ------------- //
+// !-- Perft --! //
+// ------------- //
+
+template<Color Us, bool Bulk, SliderBackend Backend>
+uint64_t perft(Position& position, int depth, PerftTable* table) {
+    if (depth == 0) return 1;
+
+    // a hit skips the move generation too
+    uint64_t nodes = 0;
+    const bool hashed = table && depth >= 2; // the last ply is cheaper to count than to look up
+    if (hashed && table->probe(position.getZobristKey(), depth, nodes)) {
+        return nodes;
+    }
+
+    MoveList moves;
+    generateLegalMoves<Us, GenType::ALL, Backend>(position, moves);
+    if (Bulk && depth == 1) return moves.size();
+    // the children below depth 2 are counted, not probed: their buckets are not worth a prefetch
+    const bool prefetch = depth >= 3;
+    for (const Move& move : moves) {
+        if (prefetch) position.play<Us>(move);
+        else position.play<Us, false>(move);
+        nodes += perft<~Us, Bulk, Backend>(position, depth - 1, table);
+        position.unplay<Us>(move);
+    }
+    if (hashed) {
+        table->store(position.getZobristKey(), depth, nodes);
+    }
+    return nodes;
+}
+
+template uint64_t perft<Color::WHITE, true, SliderBackend::MAGIC>(Position& position, int depth, PerftTable* table);
+template uint64_t perft<Color::WHITE, false, SliderBackend::MAGIC>(Position& position, int depth, PerftTable* table);
+template uint64_t perft<Color::BLACK, true, SliderBackend::MAGIC>(Position& position, int depth, PerftTable* table);
+template uint64_t perft<Color::BLACK, false, SliderBackend::MAGIC>(Position& position, int depth, PerftTable* table);
+template uint64_t perft<Color::WHITE, true, SliderBackend::PEXT>(Position& position, int depth, PerftTable* table);
+template uint64_t perft<Color::WHITE, false, SliderBackend::PEXT>(Position& position, int depth, PerftTable* table);
+template uint64_t perft<Color::BLACK, true, SliderBackend::PEXT>(Position& position, int depth, PerftTable* table);
+template uint64_t perft<Color::BLACK, false, SliderBackend::PEXT>(Position& position, int depth, PerftTable* table);
+
+/**
+ * The color, bulk and slider backend branches, taken once per call instead of once per node
+ */
+template<bool Bulk, SliderBackend Backend>
+static uint64_t perftFromActiveColor(Position& position, int depth, PerftTable* table) {
+    if (position.getActiveColor() == Color::WHITE) {
+        return perft<Color::WHITE, Bulk, Backend>(position, depth, table);
+    }
+    return perft<Color::BLACK, Bulk, Backend>(position, depth, table);
+}
+
+/**
+ * perft without touching the prefetch target: the callers attach the table once per search
+ */
+static uint64_t countNodes(Position& position, int depth, bool bulk, PerftTable* table) {
+    if (usesPextSliders()) {
+        return bulk ? perftFromActiveColor<true, SliderBackend::PEXT>(position, depth, table) : perftFromActiveColor<false, SliderBackend::PEXT>(position, depth, table);
+    }
+    return bulk ? perftFromActiveColor<true, SliderBackend::MAGIC>(position, depth, table) : perftFromActiveColor<false, SliderBackend::MAGIC>(position, depth, table);
+}
+
+uint64_t perft(Position& position, int depth, bool bulk, PerftTable* table) {
+    const PrefetchTarget previous = position.getPrefetchTarget();
+    if (table) position.setPrefetchTarget(table->getPrefetchTarget());
+    const uint64_t nodes = countNodes(position, depth, bulk, table);
+    position.setPrefetchTarget(previous);
+    return nodes;
+}
+
+std::vector<DivideEntry> divide(Position& position, int depth, bool bulk, PerftTable* table) {
+    std::vector<DivideEntry> entries;
+    if (depth == 0) return entries;
+
+    const PrefetchTarget previous = position.getPrefetchTarget();
+    if (table) position.setPrefetchTarget(table->getPrefetchTarget());
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (const Move& move : moves) {
+        position.play(move);
+        entries.push_back({move, countNodes(position, depth - 1, bulk, table)});
+        position.unplay(move);
+    }
+    position.setPrefetchTarget(previous);
+    return entries;
+}
+
+
+
+// ---------------------- //
+// !-- Parallel Perft --! //
+// ---------------------- //
+
+/**
+ * A subtree to count: the moves leading to it from the root, the first one telling which root move it belongs to
+ */
+struct PerftSubtree {
+    uint32_t rootIndex;
+    std::vector<Move> path;
+};
+
+static void collectSubtrees(Position& position, int plies, uint32_t rootIndex, std::vector<Move>& path, std::vector<PerftSubtree>& subtrees) {
+    if (plies == 0) {
+        subtrees.push_back({rootIndex, path});
+        return;
+    }
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (size_t i = 0; i < moves.size(); ++i) {
+        path.push_back(moves[i]);
+        position.play(moves[i]);
+        collectSubtrees(position, plies - 1, path.size() == 1 ? i : rootIndex, path, subtrees);
+        position.unplay(moves[i]);
+        path.pop_back();
+    }
+}
+
+std::vector<DivideEntry> parallelDivide(const Position& position, int depth, unsigned threads, bool bulk, PerftTable* table) {
+    Position root = position;
+    if (threads <= 1 || depth <= 1) {
+        return divide(root, depth, bulk, table);
+    }
+
+    // 1) Split deep enough to have several subtrees per thread (a few of them are much bigger than the others),
+    //    but keep at least one ply below the split so that bulk counting still applies
+    std::vector<PerftSubtree> subtrees;
+    std::vector<Move> path;
+    int splitPlies = 1;
+    while (true) {
+        subtrees.clear();
+        collectSubtrees(root, splitPlies, 0, path, subtrees);
+        if (subtrees.size() >= 8 * threads || splitPlies + 1 >= depth || splitPlies >= 3) break;
+        splitPlies++;
+    }
+
+    // 2) Each thread takes the next subtree until there is none left
+    std::vector<uint64_t> subtreeNodes(subtrees.size(), 0); // one writer per entry
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        Position local = position;
+        if (table) local.setPrefetchTarget(table->getPrefetchTarget());
+        size_t index;
+        while ((index = next.fetch_add(1, std::memory_order_relaxed)) < subtrees.size()) {
+            const std::vector<Move>& moves = subtrees[index].path;
+            for (const Move& move : moves) local.play(move);
+            subtreeNodes[index] = countNodes(local, depth - splitPlies, bulk, table); // the table is shared
+            for (auto it = moves.rbegin(); it != moves.rend(); ++it) local.unplay(*it);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; ++i) pool.emplace_back(worker);
+    for (std::thread& thread : pool) thread.join();
+
+    // 3) Add the subtrees up per root move
+    MoveList rootMoves;
+    generateLegalMoves(root, rootMoves);
+    std::vector<DivideEntry> entries;
+    for (const Move& move : rootMoves) entries.push_back({move, 0});
+    for (size_t i = 0; i < subtrees.size(); ++i) {
+        entries[subtrees[i].rootIndex].nodes += subtreeNodes[i];
+    }
+    return entries;
+}
+
+uint64_t parallelPerft(const Position& position, int depth, unsigned threads, bool bulk, PerftTable* table) {
+    if (threads <= 1 || depth <= 1) {
+        Position root = position;
+        return perft(root, depth, bulk, table);
+    }
+    uint64_t nodes = 0;
+    for (const DivideEntry& entry : parallelDivide(position, depth, threads, bulk, table)) {
+        nodes += entry.nodes;
+    }
+    return nodes;
+}
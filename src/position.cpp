@@ -0,0 +1,428 @@
+#include "position.hpp"
+#include "cuckoo.hpp"
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include <charconv>
+#include <cctype>
+
+
+
+// ------------------------ //
+// !-- Board Operations --! //
+// ------------------------ //
+
+void Position::putPiece(Piece piece, Square square) {
+    const Bitboard bb = squareBB(square);
+    pieceBB[piece] |= bb;
+    colorBB[getColorIndex(getColor(piece))] |= bb;
+    mailbox[square] = piece;
+    pieceCount[piece]++;
+}
+
+void Position::removePiece(Square square) {
+    const Piece piece = mailbox[square];
+    const Bitboard bb = squareBB(square);
+    pieceBB[piece] ^= bb;
+    colorBB[getColorIndex(getColor(piece))] ^= bb;
+    mailbox[square] = makePiece(Color::WHITE, Figure::EMPTY);
+    pieceCount[piece]--;
+}
+
+void Position::movePiece(Square from, Square to) {
+    const Piece piece = mailbox[from];
+    const Bitboard fromTo = squareBB(from) | squareBB(to);
+    pieceBB[piece] ^= fromTo;
+    colorBB[getColorIndex(getColor(piece))] ^= fromTo;
+    mailbox[from] = makePiece(Color::WHITE, Figure::EMPTY);
+    mailbox[to] = piece;
+}
+
+void Position::clear() {
+    for (Bitboard& bb : pieceBB) bb = 0;
+    colorBB[0] = colorBB[1] = 0;
+    for (Piece& piece : mailbox) piece = makePiece(Color::WHITE, Figure::EMPTY);
+    for (uint8_t& count : pieceCount) count = 0;
+
+    activeColor = Color::WHITE;
+    castlingRights = 0;
+    enPassantSquare = 64;
+    halfmoveClock = 0;
+    fullmoveClock = 1;
+    undoHistory.clear();
+    positionHistoryHash.clear();
+    undoHistory.reserve(HISTORY_CAPACITY); // play never allocates, unless the game gets really long
+    positionHistoryHash.reserve(HISTORY_CAPACITY);
+}
+
+
+
+// -------------------------- //
+// !-- Construction & FEN --! //
+// -------------------------- //
+
+Position::Position() : Position(startpos) {}
+
+Position::Position(std::string_view fen) {
+    fromFEN(fen);
+}
+
+const char* getFENErrorMessage(FENError error) {
+    switch (error) {
+        case FENError::NONE: return "no error";
+        case FENError::FIELDS: return "expected at least 4 fields";
+        case FENError::BOARD: return "bad piece placement";
+        case FENError::KINGS: return "each side needs exactly one king";
+        case FENError::ACTIVE_COLOR: return "active color must be 'w' or 'b'";
+        case FENError::CASTLING: return "bad castling rights";
+        case FENError::EN_PASSANT: return "bad en passant square";
+        case FENError::OPPONENT_IN_CHECK: return "the side not to move is in check";
+        case FENError::CLOCKS: return "clocks must be numbers";
+    }
+    return "unknown error";
+}
+
+/**
+ * Cuts the next space separated field off the front of fen (empty once there is none left)
+ */
+static std::string_view nextField(std::string_view& fen) {
+    size_t start = 0;
+    while (start < fen.size() && std::isspace(static_cast<unsigned char>(fen[start]))) start++;
+    size_t end = start;
+    while (end < fen.size() && !std::isspace(static_cast<unsigned char>(fen[end]))) end++;
+    const std::string_view field = fen.substr(start, end - start);
+    fen.remove_prefix(end);
+    return field;
+}
+
+static bool parseClock(std::string_view field, uint32_t& clock) {
+    const auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), clock);
+    return error == std::errc() && end == field.data() + field.size();
+}
+
+FENError Position::parseFEN(std::string_view fen) {
+    clear();
+    const std::string_view board = nextField(fen);
+    const std::string_view color = nextField(fen);
+    const std::string_view castling = nextField(fen);
+    const std::string_view enPassant = nextField(fen);
+    if (enPassant.empty()) return FENError::FIELDS;
+
+    // !-- Position --! //
+    // fen order is upside down: it starts with row 8
+    int row = 7, column = 0;
+    for (char c : board) {
+        if (c == '/') {
+            if (column != 8 || row == 0) return FENError::BOARD;
+            column = 0;
+            row--;
+        } else if (c >= '1' && c <= '8') {
+            column += c - '0';
+            if (column > 8) return FENError::BOARD;
+        } else {
+            Figure figure;
+            switch (c | 0x20) { // lower case
+                case 'p': figure = Figure::PAWN; break;
+                case 'n': figure = Figure::KNIGHT; break;
+                case 'b': figure = Figure::BISHOP; break;
+                case 'r': figure = Figure::ROOK; break;
+                case 'q': figure = Figure::QUEEN; break;
+                case 'k': figure = Figure::KING; break;
+                default: return FENError::BOARD;
+            }
+            if (column >= 8) return FENError::BOARD;
+            putPiece(makePiece(c >= 'a' ? Color::BLACK : Color::WHITE, figure), row * 8 + column);
+            column++;
+        }
+    }
+    if (row != 0 || column != 8) return FENError::BOARD;
+    if (pieceCount[makePiece(Color::WHITE, Figure::KING)] != 1 || pieceCount[makePiece(Color::BLACK, Figure::KING)] != 1) {
+        return FENError::KINGS;
+    }
+
+    // !-- Active color --! //
+    if (color == "w") activeColor = Color::WHITE;
+    else if (color == "b") activeColor = Color::BLACK;
+    else return FENError::ACTIVE_COLOR;
+
+    // !-- Castling rights --! // order: KQkq
+    if (castling != "-") {
+        for (char c : castling) {
+            switch (c) {
+                case 'K': castlingRights |= 0b1000; break;
+                case 'Q': castlingRights |= 0b0100; break;
+                case 'k': castlingRights |= 0b0010; break;
+                case 'q': castlingRights |= 0b0001; break;
+                default: return FENError::CASTLING;
+            }
+        }
+    }
+
+    // !-- En passant --! //
+    if (enPassant != "-") {
+        // the enemy pawn just went from behind the square to in front of it
+        const char epRow = activeColor == Color::WHITE ? '6' : '3';
+        if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' || enPassant[1] != epRow) {
+            return FENError::EN_PASSANT;
+        }
+        const Square square = (enPassant[1] - '1') * 8 + (enPassant[0] - 'a');
+        const int up = activeColor == Color::WHITE ? 8 : -8;
+        if (getFigure(mailbox[square]) != Figure::EMPTY || getFigure(mailbox[square + up]) != Figure::EMPTY
+            || mailbox[square - up] != makePiece(~activeColor, Figure::PAWN)) {
+            return FENError::EN_PASSANT;
+        }
+        enPassantSquare = square;
+    }
+
+    // !-- Checks --! //
+    if (isAttacked(getKingSquare(~activeColor), activeColor)) {
+        return FENError::OPPONENT_IN_CHECK;
+    }
+
+    // !-- Clocks --! //
+    const std::string_view halfmove = nextField(fen);
+    const std::string_view fullmove = nextField(fen);
+    if (!halfmove.empty() && !parseClock(halfmove, halfmoveClock)) return FENError::CLOCKS;
+    if (!fullmove.empty() && !parseClock(fullmove, fullmoveClock)) return FENError::CLOCKS;
+
+    initializeHash();
+    return FENError::NONE;
+}
+
+void Position::fromFEN(std::string_view fen) {
+    const FENError error = parseFEN(fen);
+    if (error != FENError::NONE) {
+        throw std::invalid_argument("Invalid FEN: " + std::string(getFENErrorMessage(error)) + " in '" + std::string(fen) + "'");
+    }
+}
+
+size_t Position::writeFEN(char* buffer) const {
+    char* out = buffer;
+
+    // Piece placement
+    for (int row = 7; row >= 0; row--) {
+        char empty = '0';
+        for (int col = 0; col < 8; col++) {
+            Piece piece = mailbox[row * 8 + col];
+            if (getFigure(piece) == Figure::EMPTY) {
+                empty++;
+            } else {
+                if (empty > '0') {
+                    *out++ = empty;
+                    empty = '0';
+                }
+                *out++ = getCharFromPiece(piece);
+            }
+        }
+        if (empty > '0') *out++ = empty;
+        if (row != 0) *out++ = '/';
+    }
+
+    // The rest
+    *out++ = ' ';
+    *out++ = activeColor == Color::WHITE ? 'w' : 'b';
+    *out++ = ' ';
+    if (castlingRights == 0) *out++ = '-';
+    if (castlingRights & 0b1000) *out++ = 'K';
+    if (castlingRights & 0b0100) *out++ = 'Q';
+    if (castlingRights & 0b0010) *out++ = 'k';
+    if (castlingRights & 0b0001) *out++ = 'q';
+
+    *out++ = ' ';
+    if (enPassantSquare < 64) {
+        *out++ = static_cast<char>('a' + getCol(enPassantSquare));
+        *out++ = static_cast<char>('1' + getRow(enPassantSquare));
+    } else {
+        *out++ = '-';
+    }
+    *out++ = ' ';
+    out = std::to_chars(out, buffer + FEN_LENGTH, halfmoveClock).ptr; // 10 digits at most, it fits
+    *out++ = ' ';
+    out = std::to_chars(out, buffer + FEN_LENGTH, fullmoveClock).ptr;
+    *out = '\0';
+    return out - buffer;
+}
+
+std::string Position::toFEN() const {
+    char buffer[FEN_LENGTH];
+    return std::string(buffer, writeFEN(buffer));
+}
+
+PackedPosition Position::pack() const {
+    PackedPosition packed = {};
+    packed.occupied = getOccupied();
+    Bitboard occupied = packed.occupied;
+    for (uint32_t i = 0; occupied; ++i) {
+        packed.pieces[i / 2] |= mailbox[popLsb(occupied)] << (4 * (i % 2));
+    }
+    packed.activeColor = static_cast<uint8_t>(activeColor);
+    packed.castlingRights = static_cast<uint8_t>(castlingRights);
+    packed.enPassantSquare = static_cast<uint8_t>(enPassantSquare);
+    packed.halfmoveClock = static_cast<uint8_t>(std::min<uint32_t>(halfmoveClock, 255));
+    packed.fullmoveClock = static_cast<uint16_t>(std::min<uint32_t>(fullmoveClock, 65535));
+    return packed;
+}
+
+void Position::unpack(const PackedPosition& packed) {
+    clear();
+    Bitboard occupied = packed.occupied;
+    for (uint32_t i = 0; occupied; ++i) {
+        putPiece((packed.pieces[i / 2] >> (4 * (i % 2))) & 0b1111, popLsb(occupied));
+    }
+    activeColor = static_cast<Color>(packed.activeColor);
+    castlingRights = packed.castlingRights;
+    enPassantSquare = packed.enPassantSquare;
+    halfmoveClock = packed.halfmoveClock;
+    fullmoveClock = packed.fullmoveClock;
+    initializeHash();
+}
+
+
+
+// ------------------- //
+// !-- Repetitions --! //
+// ------------------- //
+
+// positionHistoryHash.back() is the key one ply ago, so the key d plies ago is at size - d
+
+bool Position::isRepetition() const {
+    const size_t size = positionHistoryHash.size();
+    const size_t end = std::min<size_t>(halfmoveClock, size);
+    for (size_t plies = 4; plies <= end; plies += 2) {
+        if (positionHistoryHash[size - plies] == zobristKey) return true;
+    }
+    return false;
+}
+
+bool Position::isThreefoldRepetition() const {
+    const size_t size = positionHistoryHash.size();
+    const size_t end = std::min<size_t>(halfmoveClock, size);
+    int occurrences = 1;
+    for (size_t plies = 4; plies <= end; plies += 2) {
+        if (positionHistoryHash[size - plies] == zobristKey && ++occurrences == 3) return true;
+    }
+    return false;
+}
+
+bool Position::hasUpcomingRepetition(int ply) const {
+    const size_t size = positionHistoryHash.size();
+    const size_t end = std::min<size_t>(halfmoveClock, size);
+    if (end < 3) return false;
+    auto keyAt = [&](size_t plies) {return plies == 0 ? zobristKey : positionHistoryHash[size - plies];};
+
+    // 'other' is the xor of the moves of the opponent since then (each ply flips the side key, hence the
+    // extra activeColorKey): when it is 0, they are back where they were and only our pieces differ
+    uint64_t other = zobristKey ^ keyAt(1) ^ ZOBRIST.activeColorKey;
+    for (size_t plies = 3; plies <= end; plies += 2) {
+        other ^= keyAt(plies - 1) ^ keyAt(plies) ^ ZOBRIST.activeColorKey;
+        if (other != 0) continue;
+
+        // the difference must be a single reversible move, with nothing in its way
+        const uint32_t slot = CUCKOO.find(zobristKey ^ keyAt(plies));
+        if (slot == CuckooTables::SIZE) continue;
+        const Square from = CUCKOO.moves[slot] >> 6;
+        const Square to = CUCKOO.moves[slot] & 0b111111;
+        if (between(from, to) & getOccupied()) continue;
+        const Piece piece = mailbox[from] != makePiece(Color::WHITE, Figure::EMPTY) ? mailbox[from] : mailbox[to];
+        if (getColor(piece) != activeColor) continue;
+
+        if (ply > static_cast<int>(plies)) return true; // repeats a position of the search: draw
+        for (size_t earlier = plies + 4; earlier <= end; earlier += 2) { // before the root: needs a repetition
+            if (keyAt(earlier) == keyAt(plies)) return true;
+        }
+    }
+    return false;
+}
+
+
+
+// --------------------- //
+// !-- Play & Unplay --! //
+// --------------------- //
+
+template<Color Us, bool Prefetch>
+void Position::play(const Move& move) {
+    constexpr Square kingFrom = Us == Color::WHITE ? 4 : 60;
+    const Square from = move.getFrom();
+    const Square to = move.getTo();
+    const Piece piece = move.getPiece();
+
+    // 1) Save what cannot be deduced from the move
+    undoHistory.emplace_back(castlingRights, enPassantSquare, halfmoveClock);
+    positionHistoryHash.push_back(zobristKey);
+
+    // 2) Hash first: updateHash reads the rights of the current position, and the child's bucket is fetched meanwhile
+    updateHash<Us>(move);
+    if constexpr (Prefetch) prefetchTarget.prefetch(zobristKey);
+    castlingRights = getNewCastlingRights(move);
+    enPassantSquare = getNewEnPassantSquare(move);
+
+    // 3) Move the pieces
+    if (move.isCapture()) {
+        removePiece(to);
+    } else if (move.isEnPassant()) {
+        removePiece(move.getEnPassantCaptureSquare());
+    }
+    movePiece(from, to);
+
+    if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(move.getPromotion(), to);
+    } else if (move.isCastle()) {
+        if (to == kingFrom + 2) movePiece(kingFrom + 3, kingFrom + 1); // king side: h-file rook goes to f-file
+        else movePiece(kingFrom - 4, kingFrom - 1); // queen side: a-file rook goes to d-file
+    }
+
+    // 4) Clocks and turn
+    if (getFigure(piece) == Figure::PAWN || move.isCapture()) {
+        halfmoveClock = 0;
+    } else {
+        halfmoveClock++;
+    }
+    if (Us == Color::BLACK) fullmoveClock++;
+    activeColor = ~Us;
+}
+
+template<Color Us>
+void Position::unplay(const Move& move) {
+    constexpr Square kingFrom = Us == Color::WHITE ? 4 : 60;
+    const Square from = move.getFrom();
+    const Square to = move.getTo();
+
+    // 1) Turn
+    activeColor = Us;
+    if (Us == Color::BLACK) fullmoveClock--;
+
+    // 2) Put the pieces back
+    if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(makePiece(Us, Figure::PAWN), to);
+    } else if (move.isCastle()) {
+        if (to == kingFrom + 2) movePiece(kingFrom + 1, kingFrom + 3);
+        else movePiece(kingFrom - 1, kingFrom - 4);
+    }
+    movePiece(to, from);
+
+    if (move.isCapture()) {
+        putPiece(move.getCapture(), to);
+    } else if (move.isEnPassant()) {
+        putPiece(makePiece(~Us, Figure::PAWN), move.getEnPassantCaptureSquare());
+    }
+
+    // 3) Restore the rights, then the hash (restoreHash needs the rights of the position before the move)
+    const UndoInfo& undo = undoHistory.back();
+    castlingRights = undo.castlingRights;
+    enPassantSquare = undo.enPassantSquare;
+    halfmoveClock = undo.halfmoveClock;
+    undoHistory.pop_back();
+    positionHistoryHash.pop_back();
+
+    updateHash<Us>(move); // restoreHash: updateHash is an involution
+}
+
+template void Position::play<Color::WHITE, true>(const Move& move);
+template void Position::play<Color::WHITE, false>(const Move& move);
+template void Position::play<Color::BLACK, true>(const Move& move);
+template void Position::play<Color::BLACK, false>(const Move& move);
+template void Position::unplay<Color::WHITE>(const Move& move);
+template void Position::unplay<Color::BLACK>(const Move& move);
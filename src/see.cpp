@@ -0,0 +1,151 @@
+#include "see.hpp"
+#include <algorithm>
+
+
+
+// ----------------- //
+// !-- Exchanges --! //
+// ----------------- //
+
+/**
+ * Least valuable piece of the color among the attackers: returns its figure (EMPTY if there is none)
+ * and puts its square in square.
+ */
+static inline Figure getLeastValuableAttacker(const Position& position, Bitboard attackers, Color color, Square& square) {
+    for (uint32_t figure = static_cast<uint32_t>(Figure::PAWN); figure <= static_cast<uint32_t>(Figure::KING); ++figure) {
+        const Bitboard pieces = attackers & position.getPieces(color, static_cast<Figure>(figure));
+        if (pieces) {
+            square = lsb(pieces);
+            return static_cast<Figure>(figure);
+        }
+    }
+    return Figure::EMPTY;
+}
+
+/**
+ * Sliders that see the square once the piece that just captured has left its own: only the lines
+ * it was standing on can open. Knights are never on a line with the square they attack.
+ */
+template<SliderBackend Backend>
+static inline Bitboard getXRays(const Position& position, Square square, Figure figure, Bitboard occupied) {
+    Bitboard xRays = 0;
+    if (figure != Figure::ROOK && figure != Figure::KNIGHT) {
+        xRays |= bishopAttacks<Backend>(square, occupied) & position.getDiagonalSliders();
+    }
+    if (figure == Figure::ROOK || figure == Figure::QUEEN || figure == Figure::KING) {
+        xRays |= rookAttacks<Backend>(square, occupied) & position.getOrthogonalSliders();
+    }
+    return xRays;
+}
+
+/**
+ * What the move wins on its own, and the value of the piece it leaves on the square (the next one
+ * to be captured)
+ */
+static inline void getFirstCapture(const Move& move, int32_t& captured, int32_t& onSquare) {
+    captured = move.isEnPassant() ? PIECE_VALUES[static_cast<uint32_t>(Figure::PAWN)] : getPieceValue(move.getCapture());
+    onSquare = getPieceValue(move.getPiece());
+    if (move.isPromotion()) {
+        onSquare = getPieceValue(move.getPromotion());
+        captured += onSquare - PIECE_VALUES[static_cast<uint32_t>(Figure::PAWN)];
+    }
+}
+
+/**
+ * Occupancy once the move is played
+ */
+static inline Bitboard getOccupiedAfter(const Position& position, const Move& move) {
+    Bitboard occupied = position.getOccupied() ^ squareBB(move.getFrom());
+    if (move.isEnPassant()) {
+        occupied ^= squareBB(move.getEnPassantCaptureSquare());
+    }
+    return occupied;
+}
+
+template<SliderBackend Backend>
+static int32_t see(const Position& position, const Move& move) {
+    if (move.isCastle()) {
+        return 0;
+    }
+    const Square to = move.getTo();
+    int32_t gain[34]; // gain[d]: material won by the side capturing at depth d, if it is the last capture
+    int32_t onSquare;
+    getFirstCapture(move, gain[0], onSquare);
+
+    Bitboard occupied = getOccupiedAfter(position, move);
+    Bitboard attackers = position.getAttackersTo<Backend>(to, occupied) & occupied; // the sliders behind 'from' are in
+    Color side = ~getColor(move.getPiece());
+    int depth = 0;
+    while (true) {
+        Square square;
+        const Figure figure = getLeastValuableAttacker(position, attackers, side, square);
+        if (figure == Figure::EMPTY || (figure == Figure::KING && (attackers & position.getPieces(~side)))) {
+            break; // the king cannot capture a defended piece
+        }
+        depth++;
+        gain[depth] = onSquare - gain[depth - 1];
+        onSquare = PIECE_VALUES[static_cast<uint32_t>(figure)];
+        occupied ^= squareBB(square);
+        attackers = (attackers | getXRays<Backend>(position, to, figure, occupied)) & occupied;
+        side = ~side;
+    }
+
+    // each side may stop capturing instead: back up from the end of the sequence
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+template<SliderBackend Backend>
+static bool seeGE(const Position& position, const Move& move, int32_t threshold) {
+    if (move.isCastle()) {
+        return 0 >= threshold;
+    }
+    const Square to = move.getTo();
+    int32_t captured, onSquare;
+    getFirstCapture(move, captured, onSquare);
+
+    // balance: how much the side to capture must win back to change the answer
+    int32_t balance = captured - threshold;
+    if (balance < 0) {
+        return false; // not enough even if nothing recaptures
+    }
+    balance = onSquare - balance;
+    if (balance <= 0) {
+        return true; // enough even if the piece is lost for nothing
+    }
+
+    Bitboard occupied = getOccupiedAfter(position, move);
+    Bitboard attackers = position.getAttackersTo<Backend>(to, occupied) & occupied;
+    Color side = ~getColor(move.getPiece());
+    int32_t result = 1; // answer if the exchange stopped here
+    while (true) {
+        Square square;
+        const Figure figure = getLeastValuableAttacker(position, attackers, side, square);
+        if (figure == Figure::EMPTY) {
+            break;
+        }
+        result ^= 1;
+        if (figure == Figure::KING) {
+            return (attackers & position.getPieces(~side)) ? result ^ 1 : result; // only if nothing recaptures
+        }
+        balance = PIECE_VALUES[static_cast<uint32_t>(figure)] - balance;
+        if (balance < result) {
+            break; // the other side would not win enough by recapturing
+        }
+        occupied ^= squareBB(square);
+        attackers = (attackers | getXRays<Backend>(position, to, figure, occupied)) & occupied;
+        side = ~side;
+    }
+    return result;
+}
+
+int32_t see(const Position& position, const Move& move) {
+    return usesPextSliders() ? see<SliderBackend::PEXT>(position, move) : see<SliderBackend::MAGIC>(position, move);
+}
+
+bool seeGE(const Position& position, const Move& move, int32_t threshold) {
+    return usesPextSliders() ? seeGE<SliderBackend::PEXT>(position, move, threshold) : seeGE<SliderBackend::MAGIC>(position, move, threshold);
+}
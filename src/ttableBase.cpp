@@ -0,0 +1,244 @@
+#include "ttableBase.hpp"
+#include "positionBase.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+
+// -------------- //
+// !-- Memory --! //
+// -------------- //
+
+TranspositionTable::TranspositionTable(size_t megabytes, unsigned threads) {
+    resize(megabytes, threads);
+}
+
+void TranspositionTable::resize(size_t megabytes, unsigned threads) {
+    size_t count = std::max<size_t>(megabytes * 1024 * 1024 / sizeof(Bucket), 1);
+    memory = HashMemory(); // the old table goes first, so that both are never allocated at once
+    buckets = nullptr;
+    bucketCount = 0;
+
+    // the table stays usable when the memory is missing: the fallback is small enough to never fail
+    HashMemory allocated;
+    bool failed = false;
+    try {
+        allocated = HashMemory(count * sizeof(Bucket));
+    } catch (const std::bad_alloc&) {
+        count = FALLBACK_MEGABYTES * 1024 * 1024 / sizeof(Bucket);
+        allocated = HashMemory(count * sizeof(Bucket));
+        failed = true;
+    }
+    memory = std::move(allocated);
+    buckets = static_cast<Bucket*>(memory.get()); // the atomics of a zeroed bucket are valid, see clear
+    bucketCount = count;
+    clear(threads);
+    if (failed) {
+        throw std::bad_alloc();
+    }
+}
+
+void TranspositionTable::clear(unsigned threads) {
+    clearHashMemory(buckets, bucketCount * sizeof(Bucket), threads); // no thread probes during a clear
+    generation = 0;
+}
+
+
+
+// --------------------- //
+// !-- Probe & Store --! //
+// --------------------- //
+
+bool TranspositionTable::probe(uint64_t key, TTData& data) const {
+    const Bucket& bucket = getBucket(key);
+    for (size_t i = 0; i < ENTRIES_PER_BUCKET; ++i) {
+        const uint64_t word = bucket.data[i].load(std::memory_order_relaxed);
+        if (word != 0 && bucket.checks[i].load(std::memory_order_relaxed) == getCheck(key, word)) {
+            data.move = PackedMove(static_cast<uint16_t>(word));
+            data.score = static_cast<int16_t>(word >> 16);
+            data.eval = static_cast<int16_t>(word >> 32);
+            data.depth = getDepth8(word) + DEPTH_OFFSET;
+            data.bound = static_cast<Bound>(getGenerationBound(word) & 0b11);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, Bound bound, int16_t score, int16_t eval, PackedMove move) {
+    Bucket& bucket = getBucket(key);
+
+    // 1) The entry of this position if there is one, else the least valuable one: depth minus 8 per search of age
+    size_t replaced = 0;
+    uint64_t replacedData = bucket.data[0].load(std::memory_order_relaxed);
+    bool samePosition = false;
+    for (size_t i = 0; i < ENTRIES_PER_BUCKET; ++i) {
+        const uint64_t word = bucket.data[i].load(std::memory_order_relaxed);
+        if (word == 0 || bucket.checks[i].load(std::memory_order_relaxed) == getCheck(key, word)) {
+            replaced = i;
+            replacedData = word;
+            samePosition = word != 0;
+            break;
+        }
+        if (getDepth8(word) - 8 * getAge(word) < getDepth8(replacedData) - 8 * getAge(replacedData)) {
+            replaced = i;
+            replacedData = word;
+        }
+    }
+
+    // 2) Same position: keep a deeper result of this search, and the move if we have none
+    if (samePosition && move.isNull()) {
+        move = PackedMove(static_cast<uint16_t>(replacedData));
+    }
+    const int depth8 = depth - DEPTH_OFFSET;
+    uint64_t word;
+    if (samePosition && bound != Bound::EXACT && depth8 + 4 <= getDepth8(replacedData) && getAge(replacedData) == 0) {
+        word = (replacedData & ~uint64_t(0xFFFF)) | move.move;
+    } else {
+        word = makeData(move, score, eval, static_cast<uint8_t>(std::clamp(depth8, 1, 255)), static_cast<uint8_t>(generation | static_cast<uint8_t>(bound)));
+    }
+    bucket.data[replaced].store(word, std::memory_order_relaxed);
+    bucket.checks[replaced].store(getCheck(key, word), std::memory_order_relaxed);
+}
+
+int TranspositionTable::getHashfull() const {
+    const size_t sampled = std::min<size_t>(bucketCount, 1000);
+    size_t used = 0;
+    for (size_t i = 0; i < sampled; ++i) {
+        for (size_t j = 0; j < ENTRIES_PER_BUCKET; ++j) {
+            const uint64_t word = buckets[i].data[j].load(std::memory_order_relaxed);
+            used += word != 0 && (getGenerationBound(word) & GENERATION_MASK) == generation;
+        }
+    }
+    return static_cast<int>(used * 1000 / (sampled * ENTRIES_PER_BUCKET));
+}
+
+
+
+// ---------------- //
+// !-- Snapshot --! //
+// ---------------- //
+
+/**
+ * First 64 bytes of a snapshot file, the buckets follow (still cache line aligned in a mapping)
+ */
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version; // of the file and of the data word layout
+    uint32_t bucketSize;
+    uint64_t bucketCount;
+    uint64_t zobristSeed;
+    uint64_t zobristCheck; // last key generated from the seed: catches a change of the generator
+    uint32_t entriesPerBucket;
+    uint8_t generation;
+    uint8_t padding[19];
+};
+static_assert(sizeof(SnapshotHeader) == 64, "the buckets of a snapshot are cache line aligned");
+
+static constexpr char SNAPSHOT_MAGIC[8] = {'C', 'H', 'E', 'S', 'S', 'T', 'T', '\0'};
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+/**
+ * Closes the file / unmaps the snapshot whatever happens
+ */
+struct SnapshotFile {
+    int fd;
+    ~SnapshotFile() {if (fd >= 0) close(fd);}
+};
+
+struct SnapshotMapping {
+    void* address;
+    size_t length;
+    ~SnapshotMapping() {if (address != MAP_FAILED) munmap(address, length);}
+};
+
+void TranspositionTable::writeSnapshot(const std::string& path) const {
+    const size_t tableBytes = bucketCount * sizeof(Bucket);
+    const size_t fileBytes = sizeof(SnapshotHeader) + tableBytes;
+    // the blocks are reserved first: a full disk fails here, instead of faulting while writing the mapping
+    const SnapshotFile file{open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)};
+    if (file.fd < 0 || posix_fallocate(file.fd, 0, static_cast<off_t>(fileBytes)) != 0) {
+        throw std::runtime_error("Cannot write TT snapshot " + path);
+    }
+    const SnapshotMapping mapping{mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0), fileBytes};
+    if (mapping.address == MAP_FAILED) {
+        throw std::runtime_error("Cannot map TT snapshot " + path);
+    }
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.bucketSize = sizeof(Bucket);
+    header.bucketCount = bucketCount;
+    header.zobristSeed = ZOBRIST_SEED;
+    header.zobristCheck = ZOBRIST.activeColorKey;
+    header.entriesPerBucket = ENTRIES_PER_BUCKET;
+    header.generation = generation;
+    char* destination = static_cast<char*>(mapping.address);
+    std::memcpy(destination, &header, sizeof(header));
+    std::memcpy(destination + sizeof(header), buckets, tableBytes); // no thread writes between searches
+    if (msync(mapping.address, fileBytes, MS_SYNC) != 0) {
+        throw std::runtime_error("Cannot write TT snapshot " + path);
+    }
+}
+
+void TranspositionTable::save(const std::string& path) const {
+    const std::string temporaryPath = path + ".tmp";
+    try {
+        writeSnapshot(temporaryPath);
+        if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Cannot write TT snapshot " + path);
+        }
+    } catch (const std::runtime_error&) {
+        unlink(temporaryPath.c_str()); // never leave a partial snapshot behind
+        throw;
+    }
+}
+
+void TranspositionTable::load(const std::string& path) {
+    const SnapshotFile file{open(path.c_str(), O_RDONLY)};
+    struct stat status;
+    if (file.fd < 0 || fstat(file.fd, &status) != 0) {
+        throw std::runtime_error("Cannot open TT snapshot " + path);
+    }
+    const size_t fileBytes = static_cast<size_t>(status.st_size);
+    if (fileBytes < sizeof(SnapshotHeader)) {
+        throw std::runtime_error("Not a TT snapshot: " + path);
+    }
+    const SnapshotMapping mapping{mmap(nullptr, fileBytes, PROT_READ, MAP_PRIVATE, file.fd, 0), fileBytes};
+    if (mapping.address == MAP_FAILED) {
+        throw std::runtime_error("Cannot map TT snapshot " + path);
+    }
+    madvise(mapping.address, fileBytes, MADV_SEQUENTIAL);
+
+    // 1) Everything the entries depend on must be the same as in this process
+    SnapshotHeader header;
+    const char* source = static_cast<const char*>(mapping.address);
+    std::memcpy(&header, source, sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a TT snapshot: " + path);
+    }
+    if (header.version != SNAPSHOT_VERSION || header.bucketSize != sizeof(Bucket) || header.entriesPerBucket != ENTRIES_PER_BUCKET) {
+        throw std::runtime_error("TT snapshot " + path + " was written with another entry layout");
+    }
+    if (header.zobristSeed != ZOBRIST_SEED || header.zobristCheck != ZOBRIST.activeColorKey) {
+        throw std::runtime_error("TT snapshot " + path + " was written with other zobrist keys");
+    }
+    if (header.bucketCount != bucketCount) {
+        throw std::runtime_error("TT snapshot " + path + " is for a " + std::to_string(header.bucketCount * sizeof(Bucket) / (1024 * 1024)) + " MB table");
+    }
+    if (fileBytes != sizeof(SnapshotHeader) + bucketCount * sizeof(Bucket)) {
+        throw std::runtime_error("TT snapshot " + path + " is truncated");
+    }
+
+    // 2) The buckets as they were, the ages of the entries with them
+    std::memcpy(static_cast<void*>(buckets), source + sizeof(header), bucketCount * sizeof(Bucket));
+    generation = header.generation & GENERATION_MASK;
+}